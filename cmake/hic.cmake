@@ -1,6 +1,23 @@
 
+# Set HIC_TABLES to ON to make hic describe the Uis in static tables that Heaven::UiBuilder
+# instantiates at runtime, instead of generating code that creates each object on its own.
+#
+# Set HIC_LAZY to ON to make hic generate accessors that create each object on first use, instead
+# of creating all objects in setupActions(). Note that code using the Uis has to call the
+# accessors (e.g. actFoo()) instead of reading the members.
+#
+# Set HIC_MANIFEST to ON to make hic write a JSON manifest next to its outputs (hic_<name>.json,
+# or hic_batch_<outputvar>.json for HIC_BATCH). It lists the objects, merge places and
+# connections of all Uis, so tools can check them without compiling anything.
 MACRO( HIC _outputvar )
 
+    SET( _hic_flags )
+    IF( HIC_TABLES )
+        SET( _hic_flags --tables )
+    ELSEIF( HIC_LAZY )
+        SET( _hic_flags --lazy )
+    ENDIF()
+
     SET( _hics ${ARGN} )
     FOREACH( _hic ${_hics} )
 
@@ -9,13 +26,30 @@ MACRO( HIC _outputvar )
 
         SET( _out1 ${CMAKE_CURRENT_BINARY_DIR}/hic_${_basename}.h )
         SET( _out2 ${CMAKE_CURRENT_BINARY_DIR}/hic_${_basename}.cpp )
+        SET( _hic_outs ${_out1} ${_out2} )
+        SET( _hic_extra_flags )
+        SET( _hic_depfile )
+
+        IF( HIC_MANIFEST )
+            SET( _out3 ${CMAKE_CURRENT_BINARY_DIR}/hic_${_basename}.json )
+            LIST( APPEND _hic_outs ${_out3} )
+            LIST( APPEND _hic_extra_flags --manifest ${_out3} )
+        ENDIF()
+
+        # Only Ninja understands depfiles of custom commands before CMake 3.20
+        IF( CMAKE_GENERATOR MATCHES "Ninja" AND NOT CMAKE_VERSION VERSION_LESS 3.7 )
+            SET( _out4 ${CMAKE_CURRENT_BINARY_DIR}/hic_${_basename}.d )
+            LIST( APPEND _hic_extra_flags --depfile ${_out4} )
+            SET( _hic_depfile DEPFILE ${_out4} )
+        ENDIF()
 
         ADD_CUSTOM_COMMAND(
-            OUTPUT          ${_out1} ${_out2}
+            OUTPUT          ${_hic_outs}
             COMMAND         ${HIC_TOOL}
-            ARGS            ${_abs_FILE} ${_out1} ${_out2}
+            ARGS            ${_hic_flags} ${_hic_extra_flags} ${_abs_FILE} ${_out1} ${_out2}
             MAIN_DEPENDENCY ${_abs_FILE}
             DEPENDS         hic
+            ${_hic_depfile}
             COMMENT         "HIC'ing ${_basename}.hid"
         )
 
@@ -29,3 +63,96 @@ MACRO( HIC _outputvar )
     ENDFOREACH()
 
 ENDMACRO()
+
+# HIC_BATCH( <outputvar> <hid-files>... )
+#
+# Like HIC(), but compiles all given files with a single hic invocation that works on them in
+# parallel. The list of jobs is written to hic_batch_<outputvar>.txt in the current binary dir, so
+# use distinct output variables when calling this more than once in the same directory.
+MACRO( HIC_BATCH _outputvar )
+
+    SET( _hic_batch_list ${CMAKE_CURRENT_BINARY_DIR}/hic_batch_${_outputvar}.txt )
+    SET( _hic_batch_jobs "" )
+    SET( _hic_batch_outs )
+    SET( _hic_batch_deps )
+
+    SET( _hic_flags )
+    IF( HIC_TABLES )
+        SET( _hic_flags --tables )
+    ELSEIF( HIC_LAZY )
+        SET( _hic_flags --lazy )
+    ENDIF()
+
+    SET( _hics ${ARGN} )
+    FOREACH( _hic ${_hics} )
+
+        GET_FILENAME_COMPONENT(_abs_FILE ${_hic} ABSOLUTE)
+        GET_FILENAME_COMPONENT(_basename ${_hic} NAME_WE)
+
+        SET( _out1 ${CMAKE_CURRENT_BINARY_DIR}/hic_${_basename}.h )
+        SET( _out2 ${CMAKE_CURRENT_BINARY_DIR}/hic_${_basename}.cpp )
+
+        SET( _hic_batch_jobs "${_hic_batch_jobs}${_abs_FILE}\t${_out1}\t${_out2}\n" )
+        LIST( APPEND _hic_batch_outs ${_out1} ${_out2} )
+        LIST( APPEND _hic_batch_deps ${_abs_FILE} )
+
+        # we know there's nothing to moc inside
+        SET_SOURCE_FILES_PROPERTIES(
+            ${_out1}
+            PROPERTIES  SKIP_AUTOMOC TRUE )
+
+    ENDFOREACH()
+
+    # Only touch the list if it changed, so re-running cmake doesn't re-run hic.
+    FILE( WRITE ${_hic_batch_list}.tmp "${_hic_batch_jobs}" )
+    CONFIGURE_FILE( ${_hic_batch_list}.tmp ${_hic_batch_list} COPYONLY )
+
+    LIST( LENGTH _hic_batch_deps _hic_batch_count )
+
+    SET( _hic_manifest )
+    IF( HIC_MANIFEST )
+        SET( _hic_manifest ${CMAKE_CURRENT_BINARY_DIR}/hic_batch_${_outputvar}.json )
+        LIST( APPEND _hic_flags --manifest ${_hic_manifest} )
+    ENDIF()
+
+    ADD_CUSTOM_COMMAND(
+        OUTPUT          ${_hic_batch_outs} ${_hic_manifest}
+        COMMAND         ${HIC_TOOL}
+        ARGS            ${_hic_flags} --batch ${_hic_batch_list}
+        DEPENDS         ${_hic_batch_deps} ${_hic_batch_list} hic
+        COMMENT         "HIC'ing ${_hic_batch_count} files"
+    )
+
+    LIST( APPEND ${_outputvar} ${_hic_batch_outs} )
+
+ENDMACRO()
+
+# HIC_BINARY( <outputvar> <hid-files>... )
+#
+# Compiles the given files into binary Uis (hic_<name>.hidb in the current binary dir) that are
+# loaded at runtime with Heaven::UiLoader, e.g. by plugins. The output variable receives the
+# binary files; install or embed them as needed.
+MACRO( HIC_BINARY _outputvar )
+
+    SET( _hics ${ARGN} )
+    FOREACH( _hic ${_hics} )
+
+        GET_FILENAME_COMPONENT(_abs_FILE ${_hic} ABSOLUTE)
+        GET_FILENAME_COMPONENT(_basename ${_hic} NAME_WE)
+
+        SET( _out ${CMAKE_CURRENT_BINARY_DIR}/hic_${_basename}.hidb )
+
+        ADD_CUSTOM_COMMAND(
+            OUTPUT          ${_out}
+            COMMAND         ${HIC_TOOL}
+            ARGS            --binary ${_abs_FILE} ${_out}
+            MAIN_DEPENDENCY ${_abs_FILE}
+            DEPENDS         hic
+            COMMENT         "HIC'ing ${_basename}.hid into binary"
+        )
+
+        LIST( APPEND ${_outputvar} ${_out} )
+
+    ENDFOREACH()
+
+ENDMACRO()
@@ -14,6 +14,8 @@
  *
  */
 
+#include <QtAlgorithms>
+
 #include "HICObject.h"
 
 HICObject::HICObject( ObjectTypes type )
@@ -57,15 +59,22 @@ HICProperty HICObject::getProperty( const QString& name ) const
     return mProperties.value( name, HICProperty() );
 }
 
+/**
+ * @brief       Get the names of all properties in the order they were declared
+ *
+ * The order of a QHash's keys may change between runs; hic's output must not.
+ *
+ */
 QStringList HICObject::propertyNames() const
 {
-    return mProperties.keys();
+    return mPropertyOrder;
 }
 
 void HICObject::addProperty( QString name, HICProperty p )
 {
     Q_ASSERT( !mProperties.contains( name ) );
     mProperties.insert( name, p );
+    mPropertyOrder.append( name );
 }
 
 void HICObject::addContent( HICObject* content )
@@ -121,6 +130,15 @@ const HIDObjectHash& HIDModel::objects() const
     return mObjects;
 }
 
+static bool objectNameLessThan( const HICObject* a, const HICObject* b )
+{
+    return a->name() < b->name();
+}
+
+/**
+ * @brief       Get all objects of a type, sorted by their names
+ *
+ */
 HICObjects HIDModel::allObjects( ObjectTypes byType ) const
 {
     HICObjects result;
@@ -133,5 +151,6 @@ HICObjects HIDModel::allObjects( ObjectTypes byType ) const
         }
     }
 
+    qSort( result.begin(), result.end(), objectNameLessThan );
     return result;
 }
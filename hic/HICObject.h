@@ -60,6 +60,7 @@ private:
     ObjectTypes mType;
     QString mName;
     QHash< QString, HICProperty > mProperties;
+    QStringList mPropertyOrder;
     HICObjects mContent;
 };
 
@@ -16,6 +16,7 @@
 
 #include <QHash>
 #include <QString>
+#include <QKeySequence>
 
 #include "HICProperty.h"
 #include "HICObject.h"
@@ -52,6 +53,17 @@ QStringList HIDEnumerator::values() const
     return mValues;
 }
 
+/**
+ * @brief       Get the numeric value of an enumerator
+ *
+ * @return      The index of @a value in the list of values, which is its numeric value in Qt.
+ *
+ */
+int HIDEnumerator::valueOf( const QString& value ) const
+{
+    return mValues.indexOf( value );
+}
+
 QString HIDEnumerator::includeFile() const
 {
     return mIncludeFile;
@@ -67,13 +79,13 @@ QString HIDEnumerator::namespacePrefix() const
     return mNamespacePrefix;
 }
 
-HICProperty::HICProperty( const QVariant& v, HICPropertyType type )
-    : mValue( v ), mType( type )
+HICProperty::HICProperty( const QVariant& v, HICPropertyType type, int line )
+    : mValue( v ), mType( type ), mLine( line )
 {
 }
 
 HICProperty::HICProperty()
-    : mType( HICP_NULL )
+    : mType( HICP_NULL ), mLine( 0 )
 {
 }
 
@@ -87,6 +99,11 @@ HICPropertyType HICProperty::type() const
     return mType;
 }
 
+int HICProperty::line() const
+{
+    return mLine;
+}
+
 namespace HICPropertyDefs
 {
 
@@ -138,8 +155,9 @@ namespace HICPropertyDefs
             HIDEnumerator::Ptr shortcutContext( new HIDEnumerator( QLatin1String( "ShortcutContext" ),
                                                                    QLatin1String( "Qt" ),
                                                                    QLatin1String( "Qt" ) ) );
-            shortcutContext << "WidgetShortcut" << "WidgetWithChildrenShortcut"
-                            << "WindowShortcut" << "ApplicationShortcut";
+            // The enumerators are listed in the order of their values; binary output relies on it.
+            shortcutContext << "WidgetShortcut" << "WindowShortcut" << "ApplicationShortcut"
+                            << "WidgetWithChildrenShortcut";
 
             #define ADD(Class,Prop,Types) \
                 do { \
@@ -160,6 +178,10 @@ namespace HICPropertyDefs
             ADD( HACO_Action,       "_ConnectContext",  HICP_String );
             ADD( HACO_Action,       "ConnectTo",        HICP_String );
             ADD( HACO_Action,       "ConnectContext",   HICP_String );
+            ADD( HACO_Action,       "ConnectContextType", HICP_String );
+
+            ADD( HACO_Container,    "MergeInto",        HICP_String );
+            ADD( HACO_Container,    "MergePriority",    HICP_String );
 
             ADD( HACO_DynamicActionMerger, "Merger",    HICP_String );
             ADD( HACO_DynamicActionMerger, "Rebuild",   HICP_String );
@@ -168,6 +190,8 @@ namespace HICPropertyDefs
             ADD( HACO_Menu,         "StatusToolTip",    HICP_String | HICP_TRString );
 
             ADD( HACO_Ui,           "TrContext",        HICP_String );
+            ADD( HACO_Ui,           "ParentType",       HICP_String );
+            ADD( HACO_Ui,           "ParentInclude",    HICP_String );
 
             #undef ADD
         }
@@ -176,6 +200,12 @@ namespace HICPropertyDefs
     }
 
 
+    void init()
+    {
+        // Fills the static class list; must happen before any threads are started.
+        classList();
+    }
+
     bool isPropertyAllowed( HICObject* object, const QString& name, HICPropertyType type )
     {
         ClassList classes = classList();
@@ -248,4 +278,179 @@ namespace HICPropertyDefs
         return false;
     }
 
+    /**
+     * @brief       Parse an IconRef the way Heaven::IconRef::fromString() does at runtime
+     *
+     * @param[in]   text    The IconRef as written in the HID file.
+     *
+     * @param[out]  ref     Receives the root reference. Of a sub reference only its existence is
+     *                      recorded.
+     *
+     * @param[out]  error   Receives a description of what's wrong with @a text.
+     *
+     * @return      `true` if @a text is well formed. Provider names cannot be checked, since the
+     *              providers are only registered at runtime.
+     *
+     */
+    bool parseIconRef( const QString& text, HICIconRef& ref, QString& error )
+    {
+        enum { Provider, Text, Size, Parameter, SubRef, Done } mode = Provider, nextMode;
+        int lastPos = 0, curPos = 0, length = text.length();
+        bool inSubReference = false;
+
+        while( curPos <= length )
+        {
+            if( curPos != length )
+            {
+                switch( text[ curPos ].unicode() )
+                {
+                case L'#': nextMode = Text; break;
+                case L'@': nextMode = Size; break;
+                case L'$': nextMode = Parameter; break;
+                case L':': nextMode = SubRef; break;
+                default:   curPos++; continue;
+                }
+            }
+            else
+            {
+                nextMode = Done;
+            }
+
+            QString part = text.mid( lastPos, curPos - lastPos );
+
+            switch( mode )
+            {
+            case Provider:
+                if( nextMode != Text )
+                {
+                    error = QString( QLatin1String( "Expected '#' after provider in IconRef '%1'" ) )
+                            .arg( text );
+                    return false;
+                }
+
+                if( !inSubReference )
+                {
+                    ref.mProvider = part;
+                }
+                lastPos = ++curPos;
+                break;
+
+            case Text:
+                if( !inSubReference )
+                {
+                    ref.mText = part;
+                }
+                lastPos = ++curPos;
+
+                if( nextMode == Text )
+                {
+                    error = QString( QLatin1String( "Duplicate icon name in IconRef '%1'" ) )
+                            .arg( text );
+                    return false;
+                }
+                break;
+
+            case Size:
+                {
+                    bool ok = false;
+                    uint size = part.toUInt( &ok );
+                    if( !ok )
+                    {
+                        error = QString( QLatin1String( "'%1' is not a valid size in IconRef '%2'" ) )
+                                .arg( part ).arg( text );
+                        return false;
+                    }
+
+                    if( !inSubReference )
+                    {
+                        ref.mSize = int( size );
+                    }
+                }
+                lastPos = ++curPos;
+
+                if( nextMode == Text || nextMode == Size )
+                {
+                    error = QString( QLatin1String( "Unexpected '#' or '@' in IconRef '%1'" ) )
+                            .arg( text );
+                    return false;
+                }
+                break;
+
+            case Parameter:
+                if( !inSubReference )
+                {
+                    ref.mParameters.append( part );
+                }
+                lastPos = ++curPos;
+
+                if( nextMode == Text || nextMode == Size )
+                {
+                    error = QString( QLatin1String( "Unexpected '#' or '@' in IconRef '%1'" ) )
+                            .arg( text );
+                    return false;
+                }
+                break;
+
+            case Done:
+            case SubRef:
+                error = QString( QLatin1String( "Malformed IconRef '%1'" ) ).arg( text );
+                return false;
+            }
+
+            if( nextMode == SubRef )
+            {
+                ref.mHasSubReference = true;
+                inSubReference = true;
+                mode = Provider;
+            }
+            else
+            {
+                mode = nextMode;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief       Parse a shortcut the way Heaven::Action::setShortcut() does at runtime
+     *
+     * @param[in]   text    The shortcut in QKeySequence::PortableText format.
+     *
+     * @param[out]  keys    Receives the key codes of the sequence, empty if @a text is empty.
+     *
+     * @param[out]  error   Receives a description of what's wrong with @a text.
+     *
+     * @return      `true` if @a text could be parsed into a valid key sequence.
+     *
+     */
+    bool parseShortcut( const QString& text, QList< int >& keys, QString& error )
+    {
+        keys.clear();
+
+        if( text.trimmed().isEmpty() )
+        {
+            return true;
+        }
+
+        QKeySequence seq = QKeySequence::fromString( text, QKeySequence::PortableText );
+        if( seq.isEmpty() )
+        {
+            error = QString( QLatin1String( "'%1' is not a valid shortcut" ) ).arg( text );
+            return false;
+        }
+
+        for( int i = 0; i < int( seq.count() ); i++ )
+        {
+            if( seq[ i ] == Qt::Key_unknown )
+            {
+                error = QString( QLatin1String( "'%1' is not a valid shortcut" ) ).arg( text );
+                return false;
+            }
+            keys.append( seq[ i ] );
+        }
+
+        return true;
+    }
+
 }
@@ -70,6 +70,7 @@ public:
 
 public:
     QStringList values() const;
+    int valueOf( const QString& value ) const;
     QString includeFile() const;
     QString name() const;
     QString namespacePrefix() const;
@@ -87,27 +88,53 @@ inline HIDEnumerator::Ptr& operator<<( HIDEnumerator::Ptr& e, const char* value
     return e;
 }
 
+struct HICIconRef
+{
+    HICIconRef()
+        : mSize( -1 )
+        , mHasSubReference( false )
+    {
+    }
+
+    bool isSimple() const
+    {
+        return mProvider.isEmpty() && mParameters.isEmpty() && !mHasSubReference;
+    }
+
+    QString     mProvider;
+    QString     mText;
+    int         mSize;
+    QStringList mParameters;
+    bool        mHasSubReference;
+};
+
 namespace HICPropertyDefs
 {
+    void init();
     bool isPropertyAllowed( HICObject* object, const QString& name, HICPropertyType type );
     bool isPropertyValueOkay( HICObject* object, const QString& pname, const QString& pvalue,
                               HICPropertyType& finalType );
     HIDEnumerator::Ptr getEnumerator( ObjectTypes classType, const QString& name );
+
+    bool parseIconRef( const QString& text, HICIconRef& ref, QString& error );
+    bool parseShortcut( const QString& text, QList< int >& keys, QString& error );
 }
 
 class HICProperty
 {
 public:
-    HICProperty( const QVariant& v, HICPropertyType type );
+    HICProperty( const QVariant& v, HICPropertyType type, int line = 0 );
     HICProperty();
 
 public:
     QVariant value() const;
     HICPropertyType type() const;
+    int line() const;
 
 private:
     QVariant mValue;
     HICPropertyType mType;
+    int mLine;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( HICPropertyTypes )
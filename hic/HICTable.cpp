@@ -0,0 +1,477 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QHash>
+#include <QStringList>
+#include <QtAlgorithms>
+
+#include "HICTable.h"
+#include "HIGeneratorBase.h"
+
+bool findActionConnect( HICObject* obj, QString& slot, QByteArray& receiver )
+{
+    receiver = "parent";
+    slot = QString();
+
+    if( obj->hasProperty( QLatin1String( "ConnectContext" ), HICP_String ) )
+    {
+        HICProperty p2 = obj->getProperty( QLatin1String( "ConnectContext" ) );
+        receiver = p2.value().toString().toLocal8Bit();
+    }
+    else if( obj->hasProperty( QLatin1String( "_ConnectContext" ), HICP_String ) )
+    {
+        HICProperty p2 = obj->getProperty( QLatin1String( "_ConnectContext" ) );
+        receiver = p2.value().toString().toLocal8Bit();
+    }
+
+    if( obj->hasProperty( QLatin1String( "ConnectTo" ), HICP_String ) )
+    {
+        HICProperty p = obj->getProperty( QLatin1String( "ConnectTo" ) );
+        slot = p.value().toString();
+    }
+    else if( obj->hasProperty( QLatin1String( "_ConnectTo" ), HICP_String ) )
+    {
+        HICProperty p = obj->getProperty( QLatin1String( "_ConnectTo" ) );
+        slot = p.value().toString();
+    }
+
+    return !slot.isEmpty();
+}
+
+bool isToggleSlot( const QString& slot )
+{
+    return slot.contains( QLatin1String( "(bool)" ) );
+}
+
+/**
+ * @brief       Find the C++ class of the receiver of an action's connection
+ *
+ * @param[in]   uiObject    The Ui @a obj belongs to. Its `ParentType` is the class of the parent.
+ *
+ * @param[in]   obj         The action. Its `ConnectContextType` is the class of its
+ *                          `ConnectContext`.
+ *
+ * @param[in]   receiver    The receiver as found by findActionConnect().
+ *
+ * @return      The class name or an empty string, if the .hid file doesn't tell.
+ *
+ */
+QString findReceiverType( HICObject* uiObject, HICObject* obj, const QByteArray& receiver )
+{
+    QString pname = QLatin1String( receiver == "parent" ? "ParentType" : "ConnectContextType" );
+    HICObject* owner = receiver == "parent" ? uiObject : obj;
+
+    if( !owner || !owner->hasProperty( pname, HICP_String ) )
+    {
+        return QString();
+    }
+
+    return owner->getProperty( pname ).value().toString();
+}
+
+static bool mergeRouteLessThan( const HICMergeRoute& a, const HICMergeRoute& b )
+{
+    if( a.mMergePlace != b.mMergePlace )
+    {
+        return a.mMergePlace < b.mMergePlace;
+    }
+
+    return a.mPriority < b.mPriority;
+}
+
+/**
+ * @brief       Find the containers of a Ui that are merged into a merge place
+ *
+ * @param[in]   uiObject    The Ui to search.
+ *
+ * @return      One route per container with a `MergeInto` property, ordered by merge place and
+ *              then by `MergePriority`. Containers without a priority get the default of
+ *              Heaven::ActionContainer (50). Containers of the same priority stay in the order
+ *              they are declared in.
+ *
+ */
+QList< HICMergeRoute > findMergeRoutes( HICObject* uiObject )
+{
+    QList< HICMergeRoute > routes;
+
+    foreach( HICObject* obj, uiObject->content( HACO_Container ) )
+    {
+        if( !obj->hasProperty( QLatin1String( "MergeInto" ), HICP_String ) )
+        {
+            continue;
+        }
+
+        HICMergeRoute route;
+        route.mContainer = obj;
+        route.mMergePlace = obj->getProperty( QLatin1String( "MergeInto" ) ).value().toString();
+        route.mPriority = 50;
+
+        if( obj->hasProperty( QLatin1String( "MergePriority" ), HICP_String ) )
+        {
+            HICProperty p = obj->getProperty( QLatin1String( "MergePriority" ) );
+            route.mPriority = p.value().toString().toInt();
+        }
+
+        routes.append( route );
+    }
+
+    qStableSort( routes.begin(), routes.end(), mergeRouteLessThan );
+    return routes;
+}
+
+/**
+ * @brief       The distinct containers of some merge routes, in the order they are first used
+ */
+HICObjects mergeRouteContainers( const QList< HICMergeRoute >& routes )
+{
+    HICObjects containers;
+
+    foreach( const HICMergeRoute& route, routes )
+    {
+        if( !containers.contains( route.mContainer ) )
+        {
+            containers.append( route.mContainer );
+        }
+    }
+
+    return containers;
+}
+
+static const char* const sKindNames[] =
+{
+    "UiDescAction",
+    "UiDescActionGroup",
+    "UiDescWidgetAction",
+    "UiDescMergePlace",
+    "UiDescMenu",
+    "UiDescMenuBar",
+    "UiDescToolBar",
+    "UiDescContainer",
+    "UiDescDynamicActionMerger"
+};
+
+static const char* const sPropertyNames[] =
+{
+    "UiPropText",
+    "UiPropStatusToolTip",
+    "UiPropMenuRole",
+    "UiPropCheckable",
+    "UiPropChecked",
+    "UiPropVisible",
+    "UiPropEnabled",
+    "UiPropIconRef",
+    "UiPropShortcut",
+    "UiPropShortcutContext",
+    "UiPropConnectTo",
+    "UiPropMergerSlot",
+    "UiPropRebuildSignal",
+    "UiPropMergePriority",
+    "UiPropMergeInto"
+};
+
+// HID property names of the ids up to HICT_ShortcutContext
+static const char* const sHidPropertyNames[] =
+{
+    "Text",
+    "StatusToolTip",
+    "MenuRole",
+    "Checkable",
+    "Checked",
+    "Visible",
+    "Enabled",
+    "IconRef",
+    "Shortcut",
+    "ShortcutContext"
+};
+
+/**
+ * @param[in]   typedConnects   If `true`, connections to a receiver of known type are left to
+ *                              the generated code (see mConnects) instead of being described in
+ *                              the tables.
+ */
+HICTable::HICTable( bool typedConnects )
+    : mUiObject( NULL )
+    , mTypedConnects( typedConnects )
+{
+}
+
+const char* HICTable::kindName( int kind )
+{
+    return sKindNames[ kind ];
+}
+
+const char* HICTable::propertyName( HICTablePropertyId id )
+{
+    return sPropertyNames[ id ];
+}
+
+void HICTable::addProperty( int object, HICTablePropertyId id, const QString& string,
+                            bool translate )
+{
+    HICTableProperty p;
+    p.mObject = object;
+    p.mId = id;
+    p.mTranslate = translate;
+    p.mHasString = true;
+    p.mString = string;
+    p.mValue = 0;
+    mProperties.append( p );
+}
+
+void HICTable::addProperty( int object, HICTablePropertyId id, int value,
+                            const QString& expression )
+{
+    HICTableProperty p;
+    p.mObject = object;
+    p.mId = id;
+    p.mTranslate = false;
+    p.mHasString = false;
+    p.mValue = value;
+    p.mValueExpression = expression;
+    mProperties.append( p );
+}
+
+/**
+ * @brief       Collect the objects of a Ui into the tables
+ *
+ * @param[in]   uiObject    The Ui to collect.
+ *
+ * @param[out]  error       Receives a description of the problem, if there is one.
+ *
+ * @return      `false` if the Ui has a property that the tables cannot express.
+ *
+ */
+bool HICTable::collect( HICObject* uiObject, QString& error )
+{
+    QHash< HICObject*, int > indices;
+    mUiObject = uiObject;
+
+    for( int k = 0; k < HIGenObjectKindCount; k++ )
+    {
+        foreach( HICObject* obj, uiObject->content( HIGenObjectKinds[ k ].mType ) )
+        {
+            indices.insert( obj, mObjects.count() );
+            mObjects.append( obj );
+            mKinds.append( k );
+        }
+    }
+
+    for( int i = 0; i < mObjects.count(); i++ )
+    {
+        if( !collectProperties( mObjects[ i ], i, error ) )
+        {
+            return false;
+        }
+    }
+
+    foreach( HICObject* object, uiObject->content() )
+    {
+        switch( object->type() )
+        {
+        case HACO_ActionGroup:
+        case HACO_Menu:
+        case HACO_MenuBar:
+        case HACO_ToolBar:
+        case HACO_Container:
+            break;
+
+        default:
+            continue;
+        }
+
+        foreach( HICObject* child, object->content() )
+        {
+            HICTableContent content;
+            content.mContainer = indices.value( object );
+
+            if( child->type() == HACO_Separator )
+            {
+                content.mChild = -1;
+            }
+            else if( indices.contains( child ) )
+            {
+                content.mChild = indices.value( child );
+            }
+            else
+            {
+                continue;
+            }
+
+            mContent.append( content );
+        }
+    }
+
+    // Last, so UiBuilder merges the containers after they got their content and priority
+    foreach( const HICMergeRoute& route, findMergeRoutes( uiObject ) )
+    {
+        addProperty( indices.value( route.mContainer ), HICT_MergeInto, route.mMergePlace );
+    }
+
+    return true;
+}
+
+bool HICTable::collectProperties( HICObject* obj, int index, QString& error )
+{
+    ObjectTypes type = obj->type();
+    QStringList specials;
+
+    if( type == HACO_Action )
+    {
+        specials << QLatin1String( "_ConnectTo" )
+                 << QLatin1String( "_ConnectContext" )
+                 << QLatin1String( "ConnectTo" )
+                 << QLatin1String( "ConnectContext" )
+                 << QLatin1String( "ConnectContextType" );
+    }
+    else if( type == HACO_DynamicActionMerger )
+    {
+        specials << QLatin1String( "Merger" )
+                 << QLatin1String( "Rebuild" );
+    }
+    else if( type == HACO_Container )
+    {
+        // MergeInto is collected for the whole Ui in collect()
+        specials << QLatin1String( "MergeInto" )
+                 << QLatin1String( "MergePriority" );
+    }
+
+    foreach( QString pname, obj->propertyNames() )
+    {
+        if( specials.contains( pname ) )
+        {
+            continue;
+        }
+
+        HICProperty p = obj->getProperty( pname );
+
+        int id = -1;
+        for( int i = 0; i <= HICT_ShortcutContext; i++ )
+        {
+            if( pname == QLatin1String( sHidPropertyNames[ i ] ) )
+            {
+                id = i;
+                break;
+            }
+        }
+
+        if( id == -1 )
+        {
+            error = QString( QLatin1String( "Property %1 of %2 (line %3) cannot be written into "
+                                            "tables." ) )
+                    .arg( pname ).arg( obj->name() ).arg( p.line() );
+            return false;
+        }
+
+        if( id == HICT_Shortcut && p.type() == HICP_String )
+        {
+            // A single chord fits into the value; the builder won't have to parse anything.
+            QList< int > keys;
+            QString err;
+            if( HICPropertyDefs::parseShortcut( p.value().toString(), keys, err ) &&
+                keys.count() <= 1 )
+            {
+                addProperty( index, HICT_Shortcut, keys.value( 0 ) );
+                continue;
+            }
+        }
+
+        switch( p.type() )
+        {
+        case HICP_String:
+            addProperty( index, HICTablePropertyId( id ), p.value().toString() );
+            break;
+
+        case HICP_TRString:
+            addProperty( index, HICTablePropertyId( id ), p.value().toString(), true );
+            break;
+
+        case HICP_Boolean:
+            addProperty( index, HICTablePropertyId( id ), p.value().toBool() ? 1 : 0 );
+            break;
+
+        case HICP_Enum:
+            {
+                HIDEnumerator::Ptr enumerator = HICPropertyDefs::getEnumerator( type, pname );
+                QString expression = p.value().toString();
+                if( !enumerator->namespacePrefix().isEmpty() )
+                {
+                    expression = enumerator->namespacePrefix() + QLatin1String( "::" ) +
+                                 expression;
+                }
+
+                addProperty( index, HICTablePropertyId( id ),
+                             enumerator->valueOf( p.value().toString() ), expression );
+            }
+            break;
+
+        default:
+            error = QString( QLatin1String( "Property %1 of %2 (line %3) has an unknown type." ) )
+                    .arg( pname ).arg( obj->name() ).arg( p.line() );
+            return false;
+        }
+    }
+
+    if( type == HACO_Action )
+    {
+        QString slot;
+        QByteArray receiver;
+
+        if( findActionConnect( obj, slot, receiver ) )
+        {
+            bool typed = mTypedConnects &&
+                         !findReceiverType( mUiObject, obj, receiver ).isEmpty();
+
+            if( receiver == "parent" && !typed )
+            {
+                HICTableProperty p;
+                p.mObject = index;
+                p.mId = HICT_ConnectTo;
+                p.mTranslate = false;
+                p.mHasString = true;
+                p.mString = slot;
+                p.mValue = isToggleSlot( slot ) ? 1 : 0;
+                mProperties.append( p );
+            }
+            else
+            {
+                mConnects.append( obj );
+            }
+        }
+    }
+    else if( type == HACO_DynamicActionMerger )
+    {
+        if( obj->hasProperty( QLatin1String( "Merger" ), HICP_String ) )
+        {
+            HICProperty p = obj->getProperty( QLatin1String( "Merger" ) );
+            addProperty( index, HICT_MergerSlot, p.value().toString() );
+        }
+        if( obj->hasProperty( QLatin1String( "Rebuild" ), HICP_String ) )
+        {
+            HICProperty p = obj->getProperty( QLatin1String( "Rebuild" ) );
+            addProperty( index, HICT_RebuildSignal, p.value().toString() );
+        }
+    }
+    else if( type == HACO_Container )
+    {
+        if( obj->hasProperty( QLatin1String( "MergePriority" ), HICP_String ) )
+        {
+            HICProperty p = obj->getProperty( QLatin1String( "MergePriority" ) );
+            addProperty( index, HICT_MergePriority, p.value().toString().toInt() );
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,115 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef HIC_TABLE_H
+#define HIC_TABLE_H
+
+#include <QList>
+#include <QString>
+#include <QByteArray>
+
+#include "HICObject.h"
+
+// Must match Heaven::UiDescriptorProperty
+enum HICTablePropertyId
+{
+    HICT_Text,
+    HICT_StatusToolTip,
+    HICT_MenuRole,
+    HICT_Checkable,
+    HICT_Checked,
+    HICT_Visible,
+    HICT_Enabled,
+    HICT_IconRef,
+    HICT_Shortcut,
+    HICT_ShortcutContext,
+    HICT_ConnectTo,
+    HICT_MergerSlot,
+    HICT_RebuildSignal,
+    HICT_MergePriority,
+    HICT_MergeInto
+};
+
+struct HICTableProperty
+{
+    int                 mObject;
+    HICTablePropertyId  mId;
+    bool                mTranslate;
+    bool                mHasString;
+    QString             mString;
+    int                 mValue;
+    QString             mValueExpression;
+};
+
+struct HICMergeRoute
+{
+    HICObject*          mContainer;
+    QString             mMergePlace;
+    int                 mPriority;
+};
+
+struct HICTableContent
+{
+    int                 mContainer;
+    int                 mChild;         // -1 for a separator
+};
+
+/**
+ * @brief       The objects, properties and content of one Ui in the form of Heaven::UiDescriptor
+ *
+ * Objects are ordered by kind, in the order of HIGenObjectKinds; the index of a kind in there is
+ * its Heaven::UiDescriptorKind.
+ *
+ */
+class HICTable
+{
+public:
+    HICTable( bool typedConnects = false );
+
+public:
+    bool collect( HICObject* uiObject, QString& error );
+
+    static const char* kindName( int kind );
+    static const char* propertyName( HICTablePropertyId id );
+
+public:
+    HICObjects                  mObjects;
+    QList< int >                mKinds;
+    QList< HICTableProperty >   mProperties;
+    QList< HICTableContent >    mContent;
+
+    // Actions with a connection to another receiver than the parent or with a typed connection
+    HICObjects                  mConnects;
+
+private:
+    bool collectProperties( HICObject* obj, int index, QString& error );
+    void addProperty( int object, HICTablePropertyId id, const QString& string,
+                      bool translate = false );
+    void addProperty( int object, HICTablePropertyId id, int value,
+                      const QString& expression = QString() );
+
+private:
+    HICObject*                  mUiObject;
+    bool                        mTypedConnects;
+};
+
+bool findActionConnect( HICObject* obj, QString& slot, QByteArray& receiver );
+bool isToggleSlot( const QString& slot );
+QString findReceiverType( HICObject* uiObject, HICObject* obj, const QByteArray& receiver );
+QList< HICMergeRoute > findMergeRoutes( HICObject* uiObject );
+HICObjects mergeRouteContainers( const QList< HICMergeRoute >& routes );
+
+#endif
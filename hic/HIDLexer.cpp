@@ -14,238 +14,300 @@
  *
  */
 
-#include <QTextStream>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <QFile>
 
 #include "HIDLexer.h"
 
-QHash< QString, HIDTokenId > HIDLexer::sTokens;
+struct HIDKeyword
+{
+    const char* mText;
+    int         mLength;
+    HIDTokenId  mId;
+};
+
+/*
+ * Keywords by their hash (see keyword()). The multipliers of the hash were picked so that no two
+ * keywords collide; when adding a keyword, check that this still holds or pick new ones.
+ */
+static const HIDKeyword sKeywords[ 32 ] =
+{
+    { NULL,                     0,  Token_EOF                   },  //  0
+    { "true",                   4,  Token_true                  },  //  1
+    { NULL,                     0,  Token_EOF                   },  //  2
+    { "ActionGroup",            11, Token_ActionGroup           },  //  3
+    { NULL,                     0,  Token_EOF                   },  //  4
+    { NULL,                     0,  Token_EOF                   },  //  5
+    { NULL,                     0,  Token_EOF                   },  //  6
+    { "false",                  5,  Token_false                 },  //  7
+    { "Ui",                     2,  Token_Ui                    },  //  8
+    { "MenuBar",                7,  Token_MenuBar               },  //  9
+    { NULL,                     0,  Token_EOF                   },  // 10
+    { "Container",              9,  Token_Container             },  // 11
+    { "MergePlace",             10, Token_MergePlace            },  // 12
+    { "Content",                7,  Token_Content               },  // 13
+    { "DynamicActionMerger",    19, Token_DynamicActionMerger   },  // 14
+    { NULL,                     0,  Token_EOF                   },  // 15
+    { NULL,                     0,  Token_EOF                   },  // 16
+    { "Action",                 6,  Token_Action                },  // 17
+    { NULL,                     0,  Token_EOF                   },  // 18
+    { "WidgetAction",           12, Token_WidgetAction          },  // 19
+    { NULL,                     0,  Token_EOF                   },  // 20
+    { NULL,                     0,  Token_EOF                   },  // 21
+    { NULL,                     0,  Token_EOF                   },  // 22
+    { NULL,                     0,  Token_EOF                   },  // 23
+    { NULL,                     0,  Token_EOF                   },  // 24
+    { "Sep",                    3,  Token_Separator             },  // 25
+    { NULL,                     0,  Token_EOF                   },  // 26
+    { "Separator",              9,  Token_Separator             },  // 27
+    { "Menu",                   4,  Token_Menu                  },  // 28
+    { NULL,                     0,  Token_EOF                   },  // 29
+    { "ToolBar",                7,  Token_ToolBar               },  // 30
+    { NULL,                     0,  Token_EOF                   }   // 31
+};
 
+/**
+ * @brief       Tokenize a .hid file
+ *
+ * If @a fInput is a QFile, it is mapped into memory and the tokens refer to the mapping. In this
+ * case, the file must stay open as long as the values of the tokens are queried.
+ *
+ * @return      `true` on success, `false` if a syntax error was reported.
+ *
+ */
 bool HIDLexer::lex( QIODevice& fInput, HIDTokenStream& stream )
 {
-    HIDLexer lexer( stream );
-    QTextStream tsInput( &fInput );
-    tsInput.setCodec( "UTF-8" );
+    QFile* file = qobject_cast< QFile* >( &fInput );
+    QByteArray source;
+    uchar* mapped = NULL;
 
-    return lexer.tokenize( tsInput.readAll() );
+    if( file && file->size() > 0 )
+    {
+        mapped = file->map( 0, file->size() );
+    }
+
+    if( mapped )
+    {
+        source = QByteArray::fromRawData( reinterpret_cast< const char* >( mapped ),
+                                          int( file->size() ) );
+    }
+    else
+    {
+        source = fInput.readAll();
+    }
+
+    stream.setSource( source, file ? file->fileName() : QString() );
+
+    HIDLexer lexer( stream, source.constData(), source.constData() + source.size() );
+    return lexer.tokenize();
 }
 
-HIDLexer::HIDLexer( HIDTokenStream& stream )
+HIDLexer::HIDLexer( HIDTokenStream& stream, const char* begin, const char* end )
     : mOutStream( stream )
+    , mBegin( begin )
+    , mEnd( end )
+    , mLine( 1 )
+    , mColumnPos( begin )
+    , mColumn( 1 )
+{
+}
+
+HIDTokenId HIDLexer::keyword( const char* text, int length )
 {
-    if( sTokens.count() == 0 )
+    const HIDKeyword& kw = sKeywords[ ( length * 16 + uchar( text[ 0 ] ) * 3 +
+                                        uchar( text[ length - 1 ] ) ) & 31 ];
+
+    if( kw.mLength == length && memcmp( kw.mText, text, length ) == 0 )
     {
-        #define T(t) sTokens[ QLatin1String( #t ) ] = Token_##t
-        #define T2(t1,t2) sTokens[ QLatin1String( #t1 ) ] = Token_##t2
-        T(Ui);
-        T(Action);
-        T(Menu);
-        T(MenuBar);
-        T(ToolBar);
-        T(Separator);
-        T(Container);
-        T(MergePlace);
-        T(ActionGroup);
-        T(WidgetAction);
-        T(DynamicActionMerger);
-        T2(Sep,Separator);
-        T(Content);
-        T(true);
-        T(false);
-        #undef T1
-        #undef T2
+        return kw.mId;
     }
+
+    return Token_string;
 }
 
-bool HIDLexer::tokenize( const QString& text )
+void HIDLexer::newLine( const char* next )
 {
-    HIDToken nextToken;
-    int line = 1;
-    int pos = 0;
+    mLine++;
+    mColumnPos = next;
+    mColumn = 1;
+}
 
-    while( pos < text.count() )
+/**
+ * @brief       Get the column of a position in the current line
+ *
+ * Columns count characters, not bytes. Positions are asked for in ascending order, so this only
+ * has to look at the text since the last call.
+ *
+ */
+int HIDLexer::columnOf( const char* pos )
+{
+    while( mColumnPos < pos )
     {
-        Next:
-        QChar c = text[ pos++ ];
-        switch( c.unicode() )
+        // Skip UTF-8 continuation bytes
+        if( ( uchar( *mColumnPos++ ) & 0xC0 ) != 0x80 )
         {
-        case L'\n':
-            flush( line++ );
-            continue;
+            mColumn++;
+        }
+    }
 
-        case L' ':
-        case L'\t':
-        case L'\r':
-            flush( line );
-            continue;
+    return mColumn;
+}
 
-        case L'{':
-            flush( line );
-            nextToken.line = line;
-            nextToken.id = Token_OpenCurly;
-            mOutStream.append( nextToken );
-            continue;
+void HIDLexer::addToken( HIDTokenId id, const char* begin, const char* end, int line, int column )
+{
+    HIDToken t;
+    t.id = id;
+    t.line = line;
+    t.column = column;
+    t.offset = int( begin - mBegin );
+    t.length = int( end - begin );
+    mOutStream.append( t );
+}
 
-        case L'}':
-            flush( line );
-            nextToken.line = line;
-            nextToken.id = Token_CloseCurly;
-            mOutStream.append( nextToken );
-            continue;
+bool HIDLexer::error( const char* text, int line, int column )
+{
+    fprintf( stderr, "%s:%i:%i: error: %s\n",
+             qPrintable( mOutStream.fileName() ), line, column, text );
+    return false;
+}
 
-        case L'[':
-            flush( line );
-            nextToken.line = line;
-            nextToken.id = Token_OpenSquare;
-            mOutStream.append( nextToken );
-            continue;
+static inline bool isDelimiter( char c )
+{
+    switch( c )
+    {
+    case '\n': case '\r': case '\t': case ' ':
+    case '{': case '}': case '[': case ']': case ';': case ',':
+    case '\'': case '"': case '/':
+        return true;
 
-        case L']':
-            flush( line );
-            nextToken.line = line;
-            nextToken.id = Token_CloseSquare;
-            mOutStream.append( nextToken );
-            continue;
+    default:
+        return false;
+    }
+}
 
-        case L';':
-            flush( line );
-            nextToken.line = line;
-            nextToken.id = Token_Semicolon;
-            mOutStream.append( nextToken );
+bool HIDLexer::tokenize()
+{
+    const char* pos = mBegin;
+
+    // Skip a UTF-8 byte order mark
+    if( mEnd - pos >= 3 && memcmp( pos, "\xEF\xBB\xBF", 3 ) == 0 )
+    {
+        pos += 3;
+        mColumnPos = pos;
+    }
+
+    while( pos < mEnd )
+    {
+        HIDTokenId id;
+
+        switch( *pos )
+        {
+        case '\n':
+            newLine( ++pos );
             continue;
 
-        case L',':
-            flush( line );
-            nextToken.line = line;
-            nextToken.id = Token_Comma;
-            mOutStream.append( nextToken );
+        case ' ':
+        case '\t':
+        case '\r':
+            pos++;
             continue;
 
-        case L'/':
-            flush( line );
-            if( text[ pos ] == L'/' )
+        case '{':   id = Token_OpenCurly;   break;
+        case '}':   id = Token_CloseCurly;  break;
+        case '[':   id = Token_OpenSquare;  break;
+        case ']':   id = Token_CloseSquare; break;
+        case ';':   id = Token_Semicolon;   break;
+        case ',':   id = Token_Comma;       break;
+
+        case '/':
+            if( pos + 1 < mEnd && pos[ 1 ] == '/' )
             {
-                while( text[ pos ] != L'\n' )
-                    if( ++pos == text.count() )
-                        return true;	// actually, it's a successful lexer run, if we encounter
-                                        // EOF in a one-line-comment
-                line++;
+                // EOF in a one-line-comment is fine
+                while( pos < mEnd && *pos != '\n' )
+                {
+                    pos++;
+                }
                 continue;
             }
 
-            if( text[ pos ] == L'*' )
+            if( pos + 1 < mEnd && pos[ 1 ] == '*' )
             {
-                pos++;
-                while( pos < text.count() )
+                int line = mLine;
+                int column = columnOf( pos );
+
+                for( pos += 2; pos + 1 < mEnd; pos++ )
                 {
-                    switch( text[ pos ].unicode() )
+                    if( pos[ 0 ] == '*' && pos[ 1 ] == '/' )
+                    {
+                        break;
+                    }
+
+                    if( *pos == '\n' )
                     {
-                    case L'*':
-                        pos++;
-                        if( text[ pos ] == L'/' )
-                        {
-                            pos++;
-                            goto Next;
-                        }
-                        continue;
-
-                    case L'\n':
-                        line++;
-                    default:
-                        pos++;
-                        continue;
+                        newLine( pos + 1 );
                     }
                 }
+
+                if( pos + 1 >= mEnd )
+                {
+                    return error( "Unterminated comment", line, column );
+                }
+
+                pos += 2;
+                continue;
             }
-            return false;
 
-        case L'\'':
+            return error( "Unexpected '/'", mLine, columnOf( pos ) );
+
+        case '\'':
+        case '"':
             {
-                flush( line );
-                QString s;
-                while( text[ pos ] != L'\'' )
+                char quote = *pos;
+                int line = mLine;
+                int column = columnOf( pos );
+                const char* begin = ++pos;
+
+                while( pos < mEnd && *pos != quote )
                 {
-                    s += text[ pos++ ];
-                    if( pos == text.count() )
+                    if( *pos == '\n' )
                     {
-                        return false;
+                        newLine( pos + 1 );
                     }
+                    pos++;
+                }
+
+                if( pos == mEnd )
+                {
+                    return error( "Unterminated string", line, column );
                 }
-                pos++;
 
-                HIDToken t;
-                t.id = Token_string;
-                t.value = s;
-                t.line = line;
-                mOutStream.append( t );
+                addToken( quote == '"' ? Token_translateString : Token_string,
+                          begin, pos, line, column );
+                pos++;
             }
             continue;
 
-        case L'"':
+        default:
             {
-                flush( line );
-                QString s;
-                while( text[ pos ] != L'"' )
+                const char* begin = pos;
+                while( pos < mEnd && !isDelimiter( *pos ) )
                 {
-                    s += text[ pos++ ];
-                    if( pos == text.count() )
-                    {
-                        return false;
-                    }
+                    pos++;
                 }
-                pos++;
 
-                HIDToken t;
-                t.id = Token_translateString;
-                t.value = s;
-                t.line = line;
-                mOutStream.append( t );
+                addToken( keyword( begin, int( pos - begin ) ), begin, pos, mLine,
+                          columnOf( begin ) );
             }
             continue;
-
-        default:
-            currentText += c;
-            break;
         }
-    }
-
-    flush( line );
-
-    nextToken.id = Token_EOF;
-    mOutStream.append( nextToken );
 
-#if 0
-    foreach( HIDToken t, mOutStream )
-    {
-        switch( t.id )
-        {
-        case Token_string: printf( "'%s'\n", qPrintable( t.value ) ); break;
-        case Token_translateString: printf( "\"%s\"\n", qPrintable( t.value ) ); break;
-        default:
-            printf( "T(%i)\n", int(t.id) );
-            break;
-        }
+        addToken( id, pos, pos + 1, mLine, columnOf( pos ) );
+        pos++;
     }
-#endif
-    return true;
-}
 
-void HIDLexer::flush( int line )
-{
-    if( currentText.count() )
-    {
-        HIDToken t;
-        if( sTokens.contains( currentText ) )
-        {
-            t.id = sTokens[ currentText ];
-        }
-        else
-        {
-            t.id = Token_string;
-            t.value = currentText;
-        }
-        t.line = line;
-        mOutStream.append( t );
-        currentText = QString();
-    }
+    addToken( Token_EOF, mEnd, mEnd, mLine, columnOf( mEnd ) );
+    return true;
 }
-
@@ -14,6 +14,7 @@
  *
  */
 
+
 #ifndef HID_LEXER_H
 #define HID_LEXER_H
 
@@ -24,19 +25,26 @@ class QIODevice;
 class HIDLexer
 {
 private:
-	HIDLexer( HIDTokenStream& stream );
+	HIDLexer( HIDTokenStream& stream, const char* begin, const char* end );
 
 public:
 	static bool lex( QIODevice& fInput, HIDTokenStream& stream );
 
 private:
-	bool tokenize( const QString& text );
-	void flush( int line );
+	bool tokenize();
+	void newLine( const char* next );
+	int columnOf( const char* pos );
+	void addToken( HIDTokenId id, const char* begin, const char* end, int line, int column );
+	bool error( const char* text, int line, int column );
+	static HIDTokenId keyword( const char* text, int length );
 
 private:
 	HIDTokenStream& mOutStream;
-	QString currentText;
-	static QHash< QString, HIDTokenId > sTokens;
+	const char*     mBegin;
+	const char*     mEnd;
+	int             mLine;
+	const char*     mColumnPos;
+	int             mColumn;
 };
 
 #endif
@@ -33,13 +33,13 @@ HIDParser::HIDParser( const HIDTokenStream& tokenStream, HIDModel& model )
 
 void HIDParser::error( const char* pszText )
 {
-    error( pszText, mTokenStream.curToken().line );
+    error( pszText, mTokenStream.curToken() );
 }
 
-void HIDParser::error( const char* pszText, int line )
+void HIDParser::error( const char* pszText, const HIDToken& token )
 {
-    fprintf( stderr, "Error: %s at about line %i or before\n", pszText, line );
-//exit( -1 );
+    fprintf( stderr, "%s:%i:%i: error: %s\n", qPrintable( mTokenStream.fileName() ),
+             token.line, token.column, pszText );
 }
 
 bool HIDParser::parseNewObject()
@@ -233,7 +233,44 @@ bool HIDParser::tryAddProperty( const QString& pname, const QString& pvalue, HIC
         return false;
     }
 
-    currentObject->addProperty( pname, HICProperty( pvalue, ptype ) );
+    if( currentObject->type() == HACO_Action )
+    {
+        // Catch typos here instead of silently getting no icon or no shortcut at runtime.
+        QString err;
+
+        if( pname == QLatin1String( "IconRef" ) )
+        {
+            HICIconRef ref;
+            if( !HICPropertyDefs::parseIconRef( pvalue, ref, err ) )
+            {
+                error( qPrintable( err ) );
+                return false;
+            }
+        }
+        else if( pname == QLatin1String( "Shortcut" ) )
+        {
+            QList< int > keys;
+            if( !HICPropertyDefs::parseShortcut( pvalue, keys, err ) )
+            {
+                error( qPrintable( err ) );
+                return false;
+            }
+        }
+    }
+
+    if( currentObject->type() == HACO_Container && pname == QLatin1String( "MergePriority" ) )
+    {
+        bool ok = false;
+        pvalue.toInt( &ok );
+        if( !ok )
+        {
+            error( "MergePriority must be an integer" );
+            return false;
+        }
+    }
+
+    int line = mTokenStream.curToken().line;
+    currentObject->addProperty( pname, HICProperty( pvalue, ptype, line ) );
     return true;
 }
 
@@ -308,7 +345,8 @@ bool HIDParser::parseProperty()
                         return false;
                     }
                     currentObject->addProperty( pname,
-                                                HICProperty( true, HICP_Boolean ) );
+                                                HICProperty( true, HICP_Boolean,
+                                                             mTokenStream.curToken().line ) );
                     break;
 
                 case Token_false:
@@ -318,7 +356,8 @@ bool HIDParser::parseProperty()
                         return false;
                     }
                     currentObject->addProperty( pname,
-                                                HICProperty( false, HICP_Boolean ) );
+                                                HICProperty( false, HICP_Boolean,
+                                                             mTokenStream.curToken().line ) );
                     break;
 
                 default:
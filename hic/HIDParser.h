@@ -21,6 +21,7 @@ class HICObject;
 
 class HIDTokenStream;
 class HIDModel;
+struct HIDToken;
 
 class HIDParser
 {
@@ -35,7 +36,7 @@ private:
     bool parseNewObject();
     bool parseProperty();
     bool parseObjectContent();
-    void error( const char* pszText, int line );
+    void error( const char* pszText, const HIDToken& token );
     void error( const char* pszText );
     bool tryAddProperty( const QString& pname, const QString& pvalue, HICPropertyType ptype );
 
@@ -26,19 +26,48 @@ HIDTokenId HIDTokenStream::cur() const
     return endOfStream() ? Token_EOF : at( mReadPos ).id;
 }
 
+/**
+ * @brief       Set the text the tokens of this stream refer to
+ *
+ * @param[in]   source      The UTF-8 text. This may be raw data (e.g. a memory mapped file) that
+ *                          has to stay valid as long as the values of the tokens are queried.
+ *
+ * @param[in]   fileName    The name of the file the text is from, for diagnostics.
+ *
+ */
+void HIDTokenStream::setSource( const QByteArray& source, const QString& fileName )
+{
+    mSource = source;
+    mFileName = fileName;
+
+    // Rough guess, good enough to avoid most reallocations while lexing.
+    reserve( source.size() / 8 );
+}
+
 void HIDTokenStream::append( const HIDToken& token )
 {
-    QList<HIDToken>::append( token );
+    QVector< HIDToken >::append( token );
+}
+
+QString HIDTokenStream::fileName() const
+{
+    return mFileName;
+}
+
+QString HIDTokenStream::value( const HIDToken& token ) const
+{
+    return QString::fromUtf8( mSource.constData() + token.offset, token.length );
 }
 
 const HIDToken& HIDTokenStream::curToken() const
 {
-    return at( mReadPos );
+    // The last token is always Token_EOF; stay on it, if the parser tries to read beyond.
+    return at( qMin( mReadPos, count() - 1 ) );
 }
 
 QString HIDTokenStream::curValue() const
 {
-    return at( mReadPos ).value;
+    return value( curToken() );
 }
 
 void HIDTokenStream::advance() const
@@ -18,7 +18,8 @@
 #define HID_TOKEN_H
 
 #include <QString>
-#include <QList>
+#include <QByteArray>
+#include <QVector>
 
 enum HIDTokenId
 {
@@ -51,21 +52,31 @@ enum HIDTokenId
     Token_Semicolon
 };
 
+// The text of a token is not copied; it is a span of the stream's source.
 struct HIDToken
 {
     HIDTokenId  id;
     int         line;
-    QString     value;
+    int         column;
+    int         offset;
+    int         length;
 };
 
-class HIDTokenStream : private /* public */ QList< HIDToken >
+Q_DECLARE_TYPEINFO( HIDToken, Q_PRIMITIVE_TYPE );
+
+class HIDTokenStream : private /* public */ QVector< HIDToken >
 {
 public:
     HIDTokenStream();
 
 public:
+    void setSource( const QByteArray& source, const QString& fileName );
     void append( const HIDToken& token );
 
+public:
+    QString fileName() const;
+    QString value( const HIDToken& token ) const;
+
 public:
     bool endOfStream() const;
     HIDTokenId cur() const;
@@ -77,6 +88,8 @@ public:
     bool advanceAndExpect( HIDTokenId id ) const;
 
 private:
+    QByteArray  mSource;
+    QString     mFileName;
     mutable int mReadPos;
 };
 
@@ -0,0 +1,187 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <stdio.h>
+
+#include "HIGenBinary.h"
+#include "HICTable.h"
+
+static const quint16 sBinaryVersion     = 1;
+static const quint16 sByteOrderMark     = 0x0102;
+static const quint32 sNoString          = 0xFFFFFFFF;
+
+static const int sHeaderSize            = 24;
+static const int sUiSize                = 32;
+
+HIGenBinary::HIGenBinary( const HIDModel& model, const QString& fileName )
+    : HIGeneratorBase( model, fileName )
+{
+}
+
+void HIGenBinary::put16( QByteArray& data, quint16 value )
+{
+    data.append( reinterpret_cast< const char* >( &value ), sizeof( value ) );
+}
+
+void HIGenBinary::put32( QByteArray& data, quint32 value )
+{
+    data.append( reinterpret_cast< const char* >( &value ), sizeof( value ) );
+}
+
+quint32 HIGenBinary::addString( const QString& string )
+{
+    QByteArray utf8 = string.toUtf8();
+
+    QHash< QByteArray, quint32 >::const_iterator it = mStrings.constFind( utf8 );
+    if( it != mStrings.constEnd() )
+    {
+        return it.value();
+    }
+
+    quint32 offset = quint32( mStringPool.size() );
+    mStringPool.append( utf8 );
+    mStringPool.append( '\0' );
+    mStrings.insert( utf8, offset );
+
+    return offset;
+}
+
+/**
+ * @brief       Serialize all Uis of the model into the binary form
+ *
+ * The objects, properties and content are the same tables that `--tables` writes as source, so
+ * Heaven::UiLoader can hand them to Heaven::UiBuilder without any parsing.
+ *
+ * @return      `false` if a Ui cannot be expressed in binary form. That is the case for actions
+ *              connecting to another receiver than the parent, since that receiver is a C++
+ *              expression.
+ *
+ */
+bool HIGenBinary::run()
+{
+    HICObjects uis = model().allObjects( HACO_Ui );
+    QList< HICTable > tables;
+
+    mData.clear();
+    mStringPool.clear();
+    mStrings.clear();
+
+    foreach( HICObject* uiObject, uis )
+    {
+        HICTable table;
+        QString error;
+
+        if( !table.collect( uiObject, error ) )
+        {
+            fprintf( stderr, "%s: %s\n", qPrintable( fileName() ), qPrintable( error ) );
+            return false;
+        }
+
+        if( !table.mConnects.isEmpty() )
+        {
+            fprintf( stderr, "%s: Action %s of %s connects to a ConnectContext. Binary Uis can "
+                             "only connect to their parent.\n",
+                     qPrintable( fileName() ), qPrintable( table.mConnects.first()->name() ),
+                     qPrintable( uiObject->name() ) );
+            return false;
+        }
+
+        if( table.mObjects.count() >= 0xFFFF )
+        {
+            fprintf( stderr, "%s: %s has too many objects.\n",
+                     qPrintable( fileName() ), qPrintable( uiObject->name() ) );
+            return false;
+        }
+
+        tables.append( table );
+    }
+
+    QByteArray records;
+    QByteArray body;
+    quint32 bodyStart = quint32( sHeaderSize + sUiSize * uis.count() );
+
+    for( int u = 0; u < uis.count(); u++ )
+    {
+        HICObject* uiObject = uis[ u ];
+        const HICTable& table = tables[ u ];
+
+        QString ctx;
+        if( uiObject->hasProperty( QLatin1String( "TrContext" ), HICP_String ) )
+        {
+            ctx = uiObject->getProperty( QLatin1String( "TrContext" ) ).value().toString();
+        }
+        if( ctx.isEmpty() )
+        {
+            ctx = uiObject->name();
+        }
+
+        put32( records, addString( uiObject->name() ) );
+        put32( records, addString( ctx ) );
+
+        put32( records, quint32( table.mObjects.count() ) );
+        put32( records, bodyStart + quint32( body.size() ) );
+        for( int i = 0; i < table.mObjects.count(); i++ )
+        {
+            put16( body, quint16( table.mKinds[ i ] ) );
+            put16( body, 0 );
+            put32( body, addString( table.mObjects[ i ]->name() ) );
+        }
+
+        put32( records, quint32( table.mProperties.count() ) );
+        put32( records, bodyStart + quint32( body.size() ) );
+        foreach( const HICTableProperty& p, table.mProperties )
+        {
+            put16( body, quint16( p.mObject ) );
+            body.append( char( p.mId ) );
+            body.append( char( p.mTranslate ? 1 : 0 ) );
+            put32( body, p.mHasString ? addString( p.mString ) : sNoString );
+            put32( body, quint32( p.mValue ) );
+        }
+
+        put32( records, quint32( table.mContent.count() ) );
+        put32( records, bodyStart + quint32( body.size() ) );
+        foreach( const HICTableContent& c, table.mContent )
+        {
+            put16( body, quint16( c.mContainer ) );
+            put16( body, c.mChild == -1 ? quint16( 0xFFFF ) : quint16( c.mChild ) );
+        }
+    }
+
+    while( mStringPool.size() % 4 )
+    {
+        mStringPool.append( '\0' );
+    }
+
+    mData.append( "HIDB", 4 );
+    put16( mData, sBinaryVersion );
+    put16( mData, sByteOrderMark );
+    put32( mData, quint32( uis.count() ) );
+    put32( mData, quint32( sHeaderSize ) );
+    put32( mData, bodyStart + quint32( body.size() ) );
+    put32( mData, quint32( mStringPool.size() ) );
+
+    mData.append( records );
+    mData.append( body );
+    mData.append( mStringPool );
+
+    return true;
+}
+
+QByteArray HIGenBinary::output()
+{
+    return mData;
+}
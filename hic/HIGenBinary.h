@@ -0,0 +1,63 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef HI_GEN_BINARY_H
+#define HI_GEN_BINARY_H
+
+#include <QHash>
+#include <QByteArray>
+
+#include "HIGeneratorBase.h"
+
+/*
+ * Layout of a binary Ui file (.hidb), version 1. All numbers are in the byte order of the host
+ * that ran hic; the loader rejects files whose byte order marker doesn't read as 0x0102. All
+ * offsets are relative to the start of the file, string offsets are relative to the string pool.
+ *
+ *  Header:     char[4] "HIDB", u16 version, u16 byte order marker,
+ *              u32 uiCount, u32 uiTable, u32 stringPool, u32 stringPoolSize
+ *  Ui:         u32 name, u32 trContext, u32 objectCount, u32 objects,
+ *              u32 propertyCount, u32 properties, u32 contentCount, u32 content
+ *  Object:     u16 kind, u16 reserved, u32 name
+ *  Property:   u16 object, u8 property, u8 translate, u32 string, i32 value
+ *  Content:    u16 container, u16 child
+ *
+ * Kinds and properties are Heaven::UiDescriptorKind and Heaven::UiDescriptorProperty. A string
+ * of 0xFFFFFFFF means there is none. The string pool holds UTF-8 strings, each terminated by a
+ * NUL character.
+ */
+
+class HIGenBinary : public HIGeneratorBase
+{
+public:
+    HIGenBinary( const HIDModel& model, const QString& fileName );
+
+protected:
+    bool run();
+    QByteArray output();
+
+private:
+    quint32 addString( const QString& string );
+    void put16( QByteArray& data, quint16 value );
+    void put32( QByteArray& data, quint32 value );
+
+private:
+    QByteArray                  mData;
+    QByteArray                  mStringPool;
+    QHash< QByteArray, quint32 > mStrings;
+};
+
+#endif
@@ -14,25 +14,54 @@
  *
  */
 
-#include <QUuid>
-#include <QDateTime>
+#include <QFileInfo>
 
 #include "HIGenHeader.h"
 
-HIGenHeader::HIGenHeader( const HIDModel& model, const QString& fileName )
+HIGenHeader::HIGenHeader( const HIDModel& model, const QString& fileName, HIGenSetupMode mode )
     : HIGeneratorBase( model, fileName )
+    , mMode( mode )
 {
 }
 
+/**
+ * @brief       Hash the names of all Uis in the model
+ *
+ * FNV-1a over the UTF-8 encoded names, so the result doesn't depend on the Qt version or on
+ * anything but the input.
+ *
+ */
+static quint32 uiNamesHash( const HIDModel& model )
+{
+    quint32 hash = 2166136261U;
+
+    foreach( HICObject* uiObject, model.allObjects( HACO_Ui ) )
+    {
+        QByteArray name = uiObject->name().toUtf8() + ',';
+        for( int i = 0; i < name.length(); i++ )
+        {
+            hash = ( hash ^ quint8( name[ i ] ) ) * 16777619U;
+        }
+    }
+
+    return hash;
+}
+
 bool HIGenHeader::run()
 {
-    QUuid id = QUuid::createUuid();
-    QString idstr = id
-                    .toString()
-                    .toUpper()
-                    .replace( L'{', QString() )
-                    .replace( L'}', QString() )
-                    .replace( L'-', QLatin1String( "_" ) );
+    // Derive the include guard from the file name and the Uis in it, so the output only depends
+    // on the input and headers of equally named .hid files in different directories don't clash.
+    QString idstr = QFileInfo( fileName() ).fileName().toUpper();
+    for( int i = 0; i < idstr.length(); i++ )
+    {
+        if( !idstr[ i ].isLetterOrNumber() || idstr[ i ].unicode() > 127 )
+        {
+            idstr[ i ] = QLatin1Char( '_' );
+        }
+    }
+
+    idstr += QString( QLatin1String( "_%1" ) ).arg( uiNamesHash( model() ), 8, 16,
+                                                    QLatin1Char( '0' ) ).toUpper();
 
     out() << "/**********************************************************************************\n"
              "*\n"
@@ -40,8 +69,6 @@ bool HIGenHeader::run()
              "*\n"
              "* Any modifications will be lost on the next gererator run. You've been warned.\n"
              "*\n"
-             "* " << QDateTime::currentDateTime().toString( Qt::ISODate ) << "\n"
-             "*\n"
              "**********************************************************************************/\n"
              "\n"
              "#ifndef HIC_" << idstr << "\n"
@@ -59,74 +86,152 @@ bool HIGenHeader::run()
              "#include \"libHeavenActions/MergePlace.hpp\"\n"
              "#include \"libHeavenActions/ActionContainer.hpp\"\n"
              "#include \"libHeavenActions/DynamicActionMerger.hpp\"\n"
+             "#include \"libHeavenActions/UiObjectArena.hpp\"\n"
              "\n";
 
+    if( mMode == SetupLazy )
+    {
+        out() << "#include <QPointer>\n"
+                 "\n";
+    }
+
     foreach( HICObject* uiObject, model() .allObjects( HACO_Ui ) )
     {
         out() << "#ifndef HIC_" << uiObject->name() << "\n"
-                 "#define HIC_" << uiObject->name() << "\n\n"
-
-                 "class " << uiObject->name() << "\n"
-                 "{\n"
-                 "public:\n"
-                 "\tvoid setupActions( QObject* parent );\n"
-                 "\n"
-                 "private:\n"
-                 "\tstatic QString trUtf8( const char* sourceText );\n"
-                 "\n"
-                 "public:\n";
-
-        foreach( HICObject* object, uiObject->content( HACO_Action ) )
-        {
-            out() << "\tHeaven::Action*              act" << object->name() << ";\n";
-        }
+                 "#define HIC_" << uiObject->name() << "\n\n";
 
-        foreach( HICObject* object, uiObject->content( HACO_ActionGroup ) )
+        if( mMode == SetupLazy )
         {
-            out() << "\tHeaven::ActionGroup*         agrp" << object->name() << ";\n";
+            writeLazyClass( uiObject );
         }
-
-        foreach( HICObject* object, uiObject->content( HACO_WidgetAction ) )
+        else
         {
-            out() << "\tHeaven::WidgetAction*        wac" << object->name() << ";\n";
+            writeClass( uiObject );
         }
 
-        foreach( HICObject* object, uiObject->content( HACO_MergePlace ) )
-        {
-            out() << "\tHeaven::MergePlace*          mp" << object->name() << ";\n";
-        }
+        out() << "#endif\n\n";
+    }
 
-        foreach( HICObject* object, uiObject->content( HACO_Menu ) )
-        {
-            out() << "\tHeaven::Menu*                menu" << object->name() << ";\n";
-        }
+    out() << "#endif\n\n";
 
-        foreach( HICObject* object, uiObject->content( HACO_MenuBar ) )
-        {
-            out() << "\tHeaven::MenuBar*             mb" << object->name() << ";\n";
-        }
+    return true;
+}
 
-        foreach( HICObject* object, uiObject->content( HACO_ToolBar ) )
-        {
-            out() << "\tHeaven::ToolBar*             tb" << object->name() << ";\n";
-        }
+void HIGenHeader::writeClass( HICObject* uiObject )
+{
+    out() << "class " << uiObject->name() << "\n"
+             "{\n"
+             "public:\n"
+             "\tvoid setupActions( QObject* parent );\n"
+             "\n"
+             "private:\n"
+             "\tstatic QString trUtf8( const char* sourceText );\n"
+             "\n"
+             "private:\n"
+             "\tHeaven::UiObjectArena        mUiObjectArena;\n"
+             "\n"
+             "public:\n";
 
-        foreach( HICObject* object, uiObject->content( HACO_Container ) )
-        {
-            out() << "\tHeaven::ActionContainer*     ac" << object->name() << ";\n";
-        }
+    foreach( HICObject* object, uiObject->content( HACO_Action ) )
+    {
+        out() << "\tHeaven::Action*              act" << object->name() << ";\n";
+    }
+
+    foreach( HICObject* object, uiObject->content( HACO_ActionGroup ) )
+    {
+        out() << "\tHeaven::ActionGroup*         agrp" << object->name() << ";\n";
+    }
+
+    foreach( HICObject* object, uiObject->content( HACO_WidgetAction ) )
+    {
+        out() << "\tHeaven::WidgetAction*        wac" << object->name() << ";\n";
+    }
+
+    foreach( HICObject* object, uiObject->content( HACO_MergePlace ) )
+    {
+        out() << "\tHeaven::MergePlace*          mp" << object->name() << ";\n";
+    }
+
+    foreach( HICObject* object, uiObject->content( HACO_Menu ) )
+    {
+        out() << "\tHeaven::Menu*                menu" << object->name() << ";\n";
+    }
+
+    foreach( HICObject* object, uiObject->content( HACO_MenuBar ) )
+    {
+        out() << "\tHeaven::MenuBar*             mb" << object->name() << ";\n";
+    }
+
+    foreach( HICObject* object, uiObject->content( HACO_ToolBar ) )
+    {
+        out() << "\tHeaven::ToolBar*             tb" << object->name() << ";\n";
+    }
+
+    foreach( HICObject* object, uiObject->content( HACO_Container ) )
+    {
+        out() << "\tHeaven::ActionContainer*     ac" << object->name() << ";\n";
+    }
 
-        foreach( HICObject* object, uiObject->content( HACO_DynamicActionMerger ) )
+    foreach( HICObject* object, uiObject->content( HACO_DynamicActionMerger ) )
+    {
+        out() << "\tHeaven::DynamicActionMerger* dam" << object->name() << ";\n";
+    }
+
+    out() << "};\n\n";
+}
+
+void HIGenHeader::writeLazyClass( HICObject* uiObject )
+{
+    QString ui = uiObject->name();
+
+    out() << "class " << ui << "\n"
+             "{\n"
+             "public:\n"
+             "\t" << ui << "();\n"
+             "\t~" << ui << "();\n"
+             "\n"
+             "public:\n"
+             "\tvoid setupActions( QObject* parent );\n"
+             "\n"
+             "public:\n";
+
+    for( int k = 0; k < HIGenObjectKindCount; k++ )
+    {
+        const HIGenObjectKind& kind = HIGenObjectKinds[ k ];
+        QString type = QString( QLatin1String( "Heaven::%1*" ) ).arg( QLatin1String( kind.mClass ) );
+
+        foreach( HICObject* object, uiObject->content( kind.mType ) )
         {
-            out() << "\tHeaven::DynamicActionMerger* dam" << object->name() << ";\n";
+            out() << "\t" << type.leftJustified( 29 ) << kind.mPrefix << object->name() << "();\n";
         }
+    }
 
-        out() << "};\n\n";
+    out() << "\n"
+             "private:\n"
+             "\tstatic QString trUtf8( const char* sourceText );\n"
+             "\tstatic void contentProvider( void* self, Heaven::UiObject* container );\n"
+             "\tvoid fillContainer( Heaven::UiObject* container );\n"
+             "\n"
+             "private:\n"
+             "\tHeaven::UiObjectArena        mUiObjectArena;\n"
+             "\tQObject*                     mParent;\n";
 
-        out() << "#endif\n\n";
-    }
+    for( int k = 0; k < HIGenObjectKindCount; k++ )
+    {
+        const HIGenObjectKind& kind = HIGenObjectKinds[ k ];
 
-    out() << "#endif\n\n";
+        foreach( HICObject* object, uiObject->content( kind.mType ) )
+        {
+            // Containers with deferred content are guarded, because the destructor has to tell
+            // them that we're gone.
+            QString type = hasDeferredContent( object )
+                    ? QString( QLatin1String( "QPointer< Heaven::%1 >" ) )
+                    : QString( QLatin1String( "Heaven::%1*" ) );
+            type = type.arg( QLatin1String( kind.mClass ) );
+
+            out() << "\t" << type.leftJustified( 29 ) << kind.mMember << object->name() << ";\n";
+        }
+    }
 
-    return true;
+    out() << "};\n\n";
 }
@@ -22,10 +22,18 @@
 class HIGenHeader : public HIGeneratorBase
 {
 public:
-    HIGenHeader( const HIDModel& model, const QString& fileName );
+    HIGenHeader( const HIDModel& model, const QString& fileName,
+                 HIGenSetupMode mode = SetupImperative );
 
 protected:
     bool run();
+
+private:
+    void writeClass( HICObject* uiObject );
+    void writeLazyClass( HICObject* uiObject );
+
+private:
+    HIGenSetupMode mMode;
 };
 
 #endif
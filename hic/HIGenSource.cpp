@@ -14,54 +14,115 @@
  *
  */
 
-#include <QDateTime>
+#include <stdio.h>
+
+#include <QtAlgorithms>
 
 #include "HIGenSource.h"
 
-HIGenSource::HIGenSource( const HIDModel& model, const QString& fileName, const QString& baseName )
+HIGenSource::HIGenSource( const HIDModel& model, const QString& fileName, const QString& baseName,
+                          HIGenSetupMode mode )
     : HIGeneratorBase( model, fileName )
     , mBaseName( baseName )
+    , mMode( mode )
+    , mUiObject( NULL )
 {
 }
 
+/**
+ * @brief       Write the connection of an action
+ *
+ * If the .hid file tells the class of the receiver (`ParentType` of the Ui or
+ * `ConnectContextType` of the action), the connection is written as a pointer to member
+ * function for Qt 5, so it is checked by the compiler and doesn't need any lookup at runtime.
+ * Otherwise, and for Qt 4, it is written with SIGNAL() and SLOT().
+ *
+ */
 void HIGenSource::writeActionConnect( HICObject* obj, const char* whitespace, const char* prefix )
 {
     QString slot;
-    QByteArray receiver = "parent";
+    QByteArray receiver;
 
-    if( obj->hasProperty( QLatin1String( "ConnectContext" ), HICP_String ) )
+    if( !findActionConnect( obj, slot, receiver ) )
     {
-        HICProperty p2 = obj->getProperty( QLatin1String( "ConnectContext" ) );
-        receiver = p2.value().toString().toLocal8Bit();
+        return;
     }
-    else if( obj->hasProperty( QLatin1String( "_ConnectContext" ), HICP_String ) )
+
+    bool toggle = isToggleSlot( slot );
+    const char* signal = toggle ? "toggled(bool)" : "triggered()";
+    QString receiverType = findReceiverType( mUiObject, obj, receiver );
+
+    if( !receiverType.isEmpty() )
     {
-        HICProperty p2 = obj->getProperty( QLatin1String( "_ConnectContext" ) );
-        receiver = p2.value().toString().toLocal8Bit();
+        QString method = slot.left( slot.indexOf( QLatin1Char( '(' ) ) ).trimmed();
+
+        out() << "#if QT_VERSION >= 0x050000\n"
+              << whitespace << "QObject::connect( " << prefix << obj->name()
+              << ", &Heaven::Action::" << ( toggle ? "toggled" : "triggered" ) << ",\n"
+              << whitespace << "                  static_cast< " << receiverType << "* >( "
+              << receiver << " ), &" << receiverType << "::" << method << " );\n"
+                 "#else\n";
     }
 
-    if( obj->hasProperty( QLatin1String( "ConnectTo" ), HICP_String ) )
+    out() << whitespace << "QObject::connect( " << prefix << obj->name() << ", SIGNAL(" << signal
+          << "), " << receiver << ", SLOT(" << slot << ") );\n";
+
+    if( !receiverType.isEmpty() )
     {
-        HICProperty p = obj->getProperty( QLatin1String( "ConnectTo" ) );
-        slot = p.value().toString();
+        out() << "#endif\n";
     }
-    else if( obj->hasProperty( QLatin1String( "_ConnectTo" ), HICP_String ) )
+}
+
+/**
+ * @brief       Write a property that hic already parsed instead of leaving that to runtime
+ *
+ * IconRefs using the default provider are written as an IconRef constructor call. Shortcuts that
+ * are not translated are written as a QKeySequence of key codes.
+ *
+ * @return      `true` if the property was written, `false` if it has to be written as string.
+ *
+ */
+bool HIGenSource::writePreParsed( HICObject* obj, const QString& pname, const HICProperty& p,
+                                  const char* whitespace, const char* prefix )
+{
+    if( obj->type() != HACO_Action || p.type() != HICP_String )
+    {
+        return false;
+    }
+
+    QString err;
+
+    if( pname == QLatin1String( "IconRef" ) )
     {
-        HICProperty p = obj->getProperty( QLatin1String( "_ConnectTo" ) );
-        slot = p.value().toString();
+        HICIconRef ref;
+        if( !HICPropertyDefs::parseIconRef( p.value().toString(), ref, err ) || !ref.isSimple() )
+        {
+            return false;
+        }
+
+        out() << whitespace << prefix << obj->name() << "->setIconRef( Heaven::IconRef( \""
+              << utf8Encode( ref.mText ) << "\", " << ref.mSize << " ) );\n";
+        return true;
     }
 
-    if( !slot.isEmpty() )
+    if( pname == QLatin1String( "Shortcut" ) )
     {
-        const char* signal = "triggered()";
-        if( slot.contains( QLatin1String( "(bool)" ) ) )
+        QList< int > keys;
+        if( !HICPropertyDefs::parseShortcut( p.value().toString(), keys, err ) )
         {
-            signal = "toggled(bool)";
+            return false;
         }
 
-        out() << whitespace << "QObject::connect( " << prefix << obj->name() << ", SIGNAL(" << signal
-              << "), " << receiver << ", SLOT(" << slot << ") );\n";
+        out() << whitespace << prefix << obj->name() << "->setShortcut( QKeySequence(";
+        for( int i = 0; i < keys.count(); i++ )
+        {
+            out() << ( i ? ", " : " " ) << "0x" << QString::number( uint( keys[ i ] ), 16 );
+        }
+        out() << ( keys.isEmpty() ? ") );\n" : " ) );\n" );
+        return true;
     }
+
+    return false;
 }
 
 void HIGenSource::writeSetProperties( HICObject* obj, const char* whitespace, const char* prefix )
@@ -74,13 +135,19 @@ void HIGenSource::writeSetProperties( HICObject* obj, const char* whitespace, co
         specials << QLatin1String( "_ConnectTo" )       // Historic
                  << QLatin1String( "_ConnectContext" )  // Historic
                  << QLatin1String( "ConnectTo" )
-                 << QLatin1String( "ConnectContext" );
+                 << QLatin1String( "ConnectContext" )
+                 << QLatin1String( "ConnectContextType" );
     }
     else if( type == HACO_DynamicActionMerger )
     {
         specials << QLatin1String( "Merger" )
                  << QLatin1String( "Rebuild" );
     }
+    else if( type == HACO_Container )
+    {
+        specials << QLatin1String( "MergeInto" )        // See writeMergeRoutes()
+                 << QLatin1String( "MergePriority" );
+    }
 
     foreach( QString pname, obj->propertyNames() )
     {
@@ -90,6 +157,11 @@ void HIGenSource::writeSetProperties( HICObject* obj, const char* whitespace, co
         }
         HICProperty p = obj->getProperty( pname );
 
+        if( writePreParsed( obj, pname, p, whitespace, prefix ) )
+        {
+            continue;
+        }
+
         out() << whitespace << prefix << obj->name() << "->set" << pname << "( ";
 
         switch( p.type() )
@@ -147,6 +219,17 @@ void HIGenSource::writeSetProperties( HICObject* obj, const char* whitespace, co
             out() << whitespace << "QObject::connect( parent, SIGNAL(" << signal << "), "
                   << prefix << obj->name() << ", SLOT(triggerRebuild()) );\n";
         }
+        break;
+
+    case HACO_Container:
+        if( obj->hasProperty( QLatin1String( "MergePriority" ), HICP_String ) )
+        {
+            HICProperty p = obj->getProperty( QLatin1String( "MergePriority" ) );
+
+            out() << whitespace << prefix << obj->name() << "->setMergePriority( "
+                  << p.value().toString().toInt() << " );\n";
+        }
+        break;
 
     default:
         break;
@@ -158,13 +241,41 @@ void HIGenSource::findIncludes()
 {
     mIncludes.insert( QLatin1String( "QApplication" ) );
 
+    if( mMode == SetupTables )
+    {
+        mIncludes.insert( QLatin1String( "libHeavenActions/UiBuilder.hpp" ) );
+    }
+
     foreach( HICObject* uiObject, model().allObjects( HACO_Ui ) )
     {
+        if( uiObject->hasProperty( QLatin1String( "ParentInclude" ), HICP_String ) )
+        {
+            HICProperty p = uiObject->getProperty( QLatin1String( "ParentInclude" ) );
+            mIncludes.insert( p.value().toString() );
+        }
+
+        if( mMode != SetupTables && !findMergeRoutes( uiObject ).isEmpty() )
+        {
+            mIncludes.insert( QLatin1String( "libHeavenActions/UiBuilder.hpp" ) );
+        }
+
         foreach( HICObject* obj, uiObject->content() )
         {
             foreach( QString pname, obj->propertyNames() )
             {
                 HICProperty p = obj->getProperty( pname );
+                if( obj->type() == HACO_Action && p.type() == HICP_String )
+                {
+                    if( pname == QLatin1String( "IconRef" ) && mMode != SetupTables )
+                    {
+                        mIncludes.insert( QLatin1String( "libHeavenIcons/IconRef.hpp" ) );
+                    }
+                    else if( pname == QLatin1String( "Shortcut" ) )
+                    {
+                        mIncludes.insert( QLatin1String( "QKeySequence" ) );
+                    }
+                }
+
                 if( p.type() == HICP_Enum )
                 {
                     HIDEnumerator::Ptr enumerator =
@@ -190,12 +301,13 @@ bool HIGenSource::run()
              "*\n"
              "* Any modifications will be lost on the next gererator run. You've been warned.\n"
              "*\n"
-             "* " << QDateTime::currentDateTime().toString( Qt::ISODate ) << "\n"
-             "*\n"
              "**********************************************************************************/\n"
              "\n";
 
-    foreach( QString include, mIncludes )
+    QStringList includes = mIncludes.toList();
+    qSort( includes );
+
+    foreach( QString include, includes )
     {
         out() << "#include <" << include << ">\n";
     }
@@ -206,6 +318,7 @@ bool HIGenSource::run()
     foreach( HICObject* uiObject, model().allObjects( HACO_Ui ) )
     {
         QString ctx;
+        mUiObject = uiObject;
 
         if( uiObject->hasProperty( QLatin1String( "TrContext" ), HICP_String ) )
         {
@@ -228,181 +341,654 @@ bool HIGenSource::run()
                  "}\n"
                  "\n";
 
-        out() << "void " << uiObject->name() << "::" << "setupActions( QObject* parent )\n"
-                 "{\n"
-                 "\t//Setup the actions\n\n";
+        switch( mMode )
+        {
+        case SetupTables:
+            if( !writeTableSetup( uiObject, ctx ) )
+            {
+                return false;
+            }
+            break;
+
+        case SetupLazy:
+            writeLazySetup( uiObject );
+            break;
+
+        default:
+            writeImperativeSetup( uiObject );
+            break;
+        }
+    }
+
+    return true;
+}
+
+void HIGenSource::writeImperativeSetup( HICObject* uiObject )
+{
+    QList< HICMergeRoute > routes = findMergeRoutes( uiObject );
+    writeMergeRouteTable( uiObject, routes );
+
+    out() << "void " << uiObject->name() << "::" << "setupActions( QObject* parent )\n"
+             "{\n"
+             "\t// All private objects created below are freed together with this Ui\n"
+             "\tHeaven::UiObjectArena::Scope arenaScope( mUiObjectArena );\n"
+             "\n"
+             "\t//Setup the actions\n\n";
+
+    foreach( HICObject* actionObject, uiObject->content( HACO_Action ) )
+    {
+        out() << "\tact" << actionObject->name() << " = new Heaven::Action( parent );\n"
+              << "\tact" << actionObject->name() << "->setObjectName(QString::fromUtf8(\"act"
+              << actionObject->name() << "\"));\n";
+        writeSetProperties( actionObject, "\t", "act" );
+        out() << "\n";
+    }
+
+    foreach( HICObject* actionObject, uiObject->content( HACO_ActionGroup ) )
+    {
+        out() << "\tagrp" << actionObject->name() << " = new Heaven::ActionGroup( parent );\n"
+              << "\tagrp" << actionObject->name() << "->setObjectName(QString::fromUtf8(\"agrp"
+              << actionObject->name() << "\"));\n";
+        //t writeSetProperties( actionObject, "\t", "act" );
+        out() << "\n";
+    }
+
+    foreach( HICObject* actionObject, uiObject->content( HACO_WidgetAction ) )
+    {
+        out() << "\twac" << actionObject->name() << " = new Heaven::WidgetAction( parent );\n"
+              << "\twac" << actionObject->name() << "->setObjectName(QString::fromUtf8(\"wac"
+              << actionObject->name() << "\"));\n";
+        writeSetProperties( actionObject, "\t", "wac" );
+        out() << "\n";
+    }
+
+    out() << "\t//Setup Mergeplaces\n\n";
+    foreach( HICObject* mpObject, uiObject->content( HACO_MergePlace ) )
+    {
+        out() << "\tmp" << mpObject->name() << " = new Heaven::MergePlace( parent );\n"
+                 "\tmp" << mpObject->name() << "->setName( QByteArray( \"" <<
+                 latin1Encode( mpObject->name() ) << "\" ) );\n"
+              << "\tmp" << mpObject->name() << "->setObjectName(QString::fromUtf8(\"mp"
+              << mpObject->name() << "\"));\n";
+        writeSetProperties( mpObject, "\t", "mp" );
+        out() << "\n";
+    }
+
+    out() << "\t//Setup containers\n\n";
+    foreach( HICObject* menuObject, uiObject->content( HACO_Menu ) )
+    {
+        out() << "\tmenu" << menuObject->name() << " = new Heaven::Menu( parent );\n"
+              << "\tmenu" << menuObject->name() << "->setObjectName(QString::fromUtf8(\"menu"
+              << menuObject->name() << "\"));\n";
+        writeSetProperties( menuObject, "\t", "menu" );
+        out() << "\n";
+    }
+
+    foreach( HICObject* menuObject, uiObject->content( HACO_MenuBar ) )
+    {
+        out() << "\tmb" << menuObject->name() << " = new Heaven::MenuBar( parent );\n"
+              << "\tmb" << menuObject->name() << "->setObjectName(QString::fromUtf8(\"mb"
+              << menuObject->name() << "\"));\n";
+        writeSetProperties( menuObject, "\t", "mb" );
+        out() << "\n";
+    }
+
+    foreach( HICObject* menuObject, uiObject->content( HACO_ToolBar ) )
+    {
+        out() << "\ttb" << menuObject->name() << " = new Heaven::ToolBar( parent );\n"
+              << "\ttb" << menuObject->name() << "->setObjectName(QString::fromUtf8(\"tb"
+              << menuObject->name() << "\"));\n";
+        writeSetProperties( menuObject, "\t", "tb" );
+        out() << "\n";
+    }
+
+    foreach( HICObject* menuObject, uiObject->content( HACO_Container ) )
+    {
+        out() << "\tac" << menuObject->name() << " = new Heaven::ActionContainer( parent );\n"
+              << "\tac" << menuObject->name() << "->setObjectName(QString::fromUtf8(\"ac"
+              << menuObject->name() << "\"));\n";
+        writeSetProperties( menuObject, "\t", "ac" );
+        out() << "\n";
+    }
+
+    foreach( HICObject* damObject, uiObject->content( HACO_DynamicActionMerger ) )
+    {
+        out() << "\tdam" << damObject->name() << " = new Heaven::DynamicActionMerger( parent );\n"
+              << "\tdam" << damObject->name() << "->setObjectName(QString::fromUtf8(\"dam"
+              << damObject->name() << "\"));\n";
+        writeSetProperties( damObject, "\t", "dam" );
+        out() << "\n";
+    }
+
+    out() << "\t//Give containers some content\n\n";
+
+    foreach( HICObject* object, uiObject->content() )
+    {
+        const char* prefix = "";
+        switch( object->type() )
+        {
+        case HACO_Invalid:
+        case HACO_Action:
+        case HACO_MergePlace:
+        case HACO_Ui:
+        case HACO_Separator:
+        case HACO_WidgetAction:
+        case HACO_DynamicActionMerger:
+            continue;
+
+        case HACO_ActionGroup:
+            prefix = "\tagrp";
+            break;
+
+        case HACO_Menu:
+            prefix = "\tmenu";
+            break;
+
+        case HACO_MenuBar:
+            prefix = "\tmb";
+            break;
+
+        case HACO_ToolBar:
+            prefix = "\ttb";
+            break;
+
+        case HACO_Container:
+            prefix = "\tac";
+            break;
+        }
+
+        foreach( HICObject* child, object->content() )
+        {
+            switch( child->type() )
+            {
+            case HACO_Separator:
+                out() << prefix << object->name() << "->addSeparator();\n";
+                break;
+
+            case HACO_Action:
+                out() << prefix << object->name() << "->add( act" << child->name() << " );\n";
+                break;
+
+            case HACO_ActionGroup:
+                out() << prefix << object->name() << "->add( agrp" << child->name() << " );\n";
+                break;
+
+            case HACO_WidgetAction:
+                out() << prefix << object->name() << "->add( wac" << child->name() << " );\n";
+                break;
+
+            case HACO_Container:
+                out() << prefix << object->name() << "->add( ac" << child->name() << " );\n";
+                break;
+
+            case HACO_MergePlace:
+                out() << prefix << object->name() << "->add( mp" << child->name() << " );\n";
+                break;
+
+            case HACO_Menu:
+                out() << prefix << object->name() << "->add( menu" << child->name() << " );\n";
+                break;
+
+            case HACO_DynamicActionMerger:
+                out() << prefix << object->name() << "->add( dam" << child->name() << " );\n";
+                break;
+
+            case HACO_ToolBar:
+            case HACO_MenuBar:
+            case HACO_Invalid:
+            case HACO_Ui:
+                break;
+            }
+        }
+
+        out() << "\n";
+    }
+
+    writeMergeRoutes( uiObject, routes, "" );
+
+    out() << "}\n\n";
+}
+
+/**
+ * @brief       Write the merge routes of a Ui as a static Heaven::UiMergeRoute table
+ *
+ * The routes index into the array of containers that writeMergeRoutes() writes.
+ *
+ */
+void HIGenSource::writeMergeRouteTable( HICObject* uiObject, const QList< HICMergeRoute >& routes )
+{
+    HICObjects containers = mergeRouteContainers( routes );
+    QStringList rows;
+
+    foreach( const HICMergeRoute& route, routes )
+    {
+        rows << QString( QLatin1String( "\t{ %1, \"%2\" }," ) )
+                .arg( containers.indexOf( route.mContainer ) )
+                .arg( latin1Encode( route.mMergePlace ) );
+    }
+
+    writeTable( "UiMergeRoute", QLatin1String( "s" ) + uiObject->name() +
+                QLatin1String( "MergeRoutes" ), rows );
+}
+
+/**
+ * @brief       Write the code that merges the containers of a Ui into their merge places
+ *
+ * The routes are already sorted by merge place and priority, so Heaven::UiBuilder::merge() can
+ * fill each merge place in a single pass.
+ *
+ * @param[in]   accessor    Appended to the name of each container; `"()"` in lazy mode.
+ *
+ */
+void HIGenSource::writeMergeRoutes( HICObject* uiObject, const QList< HICMergeRoute >& routes,
+                                    const char* accessor )
+{
+    if( routes.isEmpty() )
+    {
+        return;
+    }
+
+    HICObjects containers = mergeRouteContainers( routes );
+
+    out() << "\t//Merge containers into their merge places\n\n"
+             "\tHeaven::UiObject* routeContainers[] =\n"
+             "\t{\n";
+
+    foreach( HICObject* container, containers )
+    {
+        out() << "\t\tac" << container->name() << accessor << ",\n";
+    }
+
+    out() << "\t};\n"
+             "\tHeaven::UiBuilder::merge( s" << uiObject->name() << "MergeRoutes, "
+          << routes.count() << ", routeContainers );\n";
+}
+
+void HIGenSource::writeTable( const char* type, const QString& name, const QStringList& rows )
+{
+    if( rows.isEmpty() )
+    {
+        return;
+    }
+
+    out() << "static const Heaven::" << type << " " << name << "[] =\n"
+             "{\n";
+
+    foreach( QString row, rows )
+    {
+        out() << row << "\n";
+    }
 
-        foreach( HICObject* actionObject, uiObject->content( HACO_Action ) )
+    out() << "};\n\n";
+}
+
+/**
+ * @brief       Write setupActions() for a Ui in table form
+ *
+ * Instead of creating and configuring each object with its own calls, the objects, their
+ * properties and the content of the containers are written into static tables that
+ * Heaven::UiBuilder instantiates at runtime. setupActions() then only has to hand the tables to
+ * the builder and pick the created objects up into the Ui's members.
+ *
+ */
+bool HIGenSource::writeTableSetup( HICObject* uiObject, const QString& ctx )
+{
+    QString ui = uiObject->name();
+    QString error;
+    HICTable table( true );
+
+    if( !table.collect( uiObject, error ) )
+    {
+        fprintf( stderr, "%s: %s\n", qPrintable( fileName() ), qPrintable( error ) );
+        return false;
+    }
+
+    QStringList objectRows, propertyRows, contentRows;
+
+    for( int i = 0; i < table.mObjects.count(); i++ )
+    {
+        objectRows << QString( QLatin1String( "\t{ Heaven::%1, \"%2\" }," ) )
+                      .arg( QLatin1String( HICTable::kindName( table.mKinds[ i ] ) ) )
+                      .arg( latin1Encode( table.mObjects[ i ]->name() ) );
+    }
+
+    foreach( const HICTableProperty& p, table.mProperties )
+    {
+        QString row = QString( QLatin1String( "\t{ %1, Heaven::%2, " ) )
+                .arg( p.mObject ).arg( QLatin1String( HICTable::propertyName( p.mId ) ) );
+
+        if( p.mHasString )
         {
-            out() << "\tact" << actionObject->name() << " = new Heaven::Action( parent );\n"
-                  << "\tact" << actionObject->name() << "->setObjectName(QString::fromUtf8(\"act"
-                  << actionObject->name() << "\"));\n";
-            writeSetProperties( actionObject, "\t", "act" );
-            out() << "\n";
+            // Substitute all at once, the text may contain place markers itself
+            row += QString( QLatin1String( "%1, \"%2\", %3 }," ) )
+                   .arg( QString::number( p.mTranslate ? 1 : 0 ),
+                         p.mTranslate ? utf8Encode( p.mString ) : latin1Encode( p.mString ),
+                         QString::number( p.mValue ) );
         }
+        else if( !p.mValueExpression.isEmpty() )
+        {
+            row += QLatin1String( "0, NULL, int( " ) + p.mValueExpression +
+                   QLatin1String( " ) }," );
+        }
+        else if( p.mId == HICT_Shortcut )
+        {
+            row += QString( QLatin1String( "0, NULL, 0x%1 }," ) ).arg( uint( p.mValue ), 0, 16 );
+        }
+        else
+        {
+            row += QString( QLatin1String( "0, NULL, %1 }," ) ).arg( p.mValue );
+        }
+
+        propertyRows << row;
+    }
 
-        foreach( HICObject* actionObject, uiObject->content( HACO_ActionGroup ) )
+    foreach( const HICTableContent& c, table.mContent )
+    {
+        if( c.mChild == -1 )
+        {
+            contentRows << QString( QLatin1String( "\t{ %1, Heaven::UiContentSeparator }," ) )
+                           .arg( c.mContainer );
+        }
+        else
         {
-            out() << "\tagrp" << actionObject->name() << " = new Heaven::ActionGroup( parent );\n"
-                  << "\tagrp" << actionObject->name() << "->setObjectName(QString::fromUtf8(\"agrp"
-                  << actionObject->name() << "\"));\n";
-            //t writeSetProperties( actionObject, "\t", "act" );
-            out() << "\n";
+            contentRows << QString( QLatin1String( "\t{ %1, %2 }," ) )
+                           .arg( c.mContainer ).arg( c.mChild );
         }
+    }
+
+    writeTable( "UiObjectDescriptor", QLatin1String( "s" ) + ui + QLatin1String( "Objects" ),
+                objectRows );
+    writeTable( "UiPropertyDescriptor", QLatin1String( "s" ) + ui + QLatin1String( "Properties" ),
+                propertyRows );
+    writeTable( "UiContentDescriptor", QLatin1String( "s" ) + ui + QLatin1String( "Content" ),
+                contentRows );
+
+    out() << "static const Heaven::UiDescriptor s" << ui << "Descriptor =\n"
+             "{\n"
+             "\t\"" << latin1Encode( ctx ) << "\",\n";
 
-        foreach( HICObject* actionObject, uiObject->content( HACO_WidgetAction ) )
+    if( objectRows.isEmpty() )
+    {
+        out() << "\tNULL, 0,\n";
+    }
+    else
+    {
+        out() << "\ts" << ui << "Objects, " << objectRows.count() << ",\n";
+    }
+
+    if( propertyRows.isEmpty() )
+    {
+        out() << "\tNULL, 0,\n";
+    }
+    else
+    {
+        out() << "\ts" << ui << "Properties, " << propertyRows.count() << ",\n";
+    }
+
+    if( contentRows.isEmpty() )
+    {
+        out() << "\tNULL, 0\n";
+    }
+    else
+    {
+        out() << "\ts" << ui << "Content, " << contentRows.count() << "\n";
+    }
+
+    out() << "};\n\n";
+
+    out() << "void " << ui << "::" << "setupActions( QObject* parent )\n"
+             "{\n"
+             "\t// All private objects created below are freed together with this Ui\n"
+             "\tHeaven::UiObjectArena::Scope arenaScope( mUiObjectArena );\n"
+             "\n";
+
+    if( !table.mObjects.isEmpty() )
+    {
+        out() << "\tHeaven::UiObject* objects[ " << table.mObjects.count() << " ];\n"
+                 "\tHeaven::UiBuilder::build( s" << ui << "Descriptor, parent, objects );\n"
+                 "\n";
+
+        for( int i = 0; i < table.mObjects.count(); i++ )
         {
-            out() << "\twac" << actionObject->name() << " = new Heaven::WidgetAction( parent );\n"
-                  << "\twac" << actionObject->name() << "->setObjectName(QString::fromUtf8(\"wac"
-                  << actionObject->name() << "\"));\n";
-            writeSetProperties( actionObject, "\t", "wac" );
-            out() << "\n";
+            const HIGenObjectKind& kind = HIGenObjectKinds[ table.mKinds[ i ] ];
+            out() << "\t" << kind.mPrefix << table.mObjects[ i ]->name()
+                  << " = static_cast< Heaven::" << kind.mClass << "* >( objects[ " << i << " ] );\n";
         }
+    }
 
-        out() << "\t//Setup Mergeplaces\n\n";
-        foreach( HICObject* mpObject, uiObject->content( HACO_MergePlace ) )
+    if( !table.mConnects.isEmpty() )
+    {
+        out() << "\n";
+        foreach( HICObject* obj, table.mConnects )
         {
-            out() << "\tmp" << mpObject->name() << " = new Heaven::MergePlace( parent );\n"
-                     "\tmp" << mpObject->name() << "->setName( QByteArray( \"" <<
-                     latin1Encode( mpObject->name() ) << "\" ) );\n"
-                  << "\tmp" << mpObject->name() << "->setObjectName(QString::fromUtf8(\"mp"
-                  << mpObject->name() << "\"));\n";
-            writeSetProperties( mpObject, "\t", "mp" );
-            out() << "\n";
+            writeActionConnect( obj, "\t", "act" );
         }
+    }
+
+    out() << "}\n\n";
+
+    return true;
+}
 
-        out() << "\t//Setup containers\n\n";
-        foreach( HICObject* menuObject, uiObject->content( HACO_Menu ) )
+static const HIGenObjectKind* kindOf( ObjectTypes type )
+{
+    for( int k = 0; k < HIGenObjectKindCount; k++ )
+    {
+        if( HIGenObjectKinds[ k ].mType == type )
         {
-            out() << "\tmenu" << menuObject->name() << " = new Heaven::Menu( parent );\n"
-                  << "\tmenu" << menuObject->name() << "->setObjectName(QString::fromUtf8(\"menu"
-                  << menuObject->name() << "\"));\n";
-            writeSetProperties( menuObject, "\t", "menu" );
-            out() << "\n";
+            return &HIGenObjectKinds[ k ];
         }
+    }
+
+    return NULL;
+}
+
+static bool containsShortcuts( HICObject* obj, QSet< HICObject* >& visited )
+{
+    if( visited.contains( obj ) )
+    {
+        return false;
+    }
+    visited.insert( obj );
 
-        foreach( HICObject* menuObject, uiObject->content( HACO_MenuBar ) )
+    foreach( HICObject* child, obj->content() )
+    {
+        if( child->type() == HACO_Action &&
+            child->hasProperty( QLatin1String( "Shortcut" ) ) )
         {
-            out() << "\tmb" << menuObject->name() << " = new Heaven::MenuBar( parent );\n"
-                  << "\tmb" << menuObject->name() << "->setObjectName(QString::fromUtf8(\"mb"
-                  << menuObject->name() << "\"));\n";
-            writeSetProperties( menuObject, "\t", "mb" );
-            out() << "\n";
+            return true;
         }
 
-        foreach( HICObject* menuObject, uiObject->content( HACO_ToolBar ) )
+        // Containers from other Uis may get merged into the place. We cannot tell whether they
+        // have shortcuts, and the place doesn't exist until the content is provided.
+        if( child->type() == HACO_MergePlace )
         {
-            out() << "\ttb" << menuObject->name() << " = new Heaven::ToolBar( parent );\n"
-                  << "\ttb" << menuObject->name() << "->setObjectName(QString::fromUtf8(\"tb"
-                  << menuObject->name() << "\"));\n";
-            writeSetProperties( menuObject, "\t", "tb" );
-            out() << "\n";
+            return true;
         }
 
-        foreach( HICObject* menuObject, uiObject->content( HACO_Container ) )
+        if( containsShortcuts( child, visited ) )
         {
-            out() << "\tac" << menuObject->name() << " = new Heaven::ActionContainer( parent );\n"
-                  << "\tac" << menuObject->name() << "->setObjectName(QString::fromUtf8(\"ac"
-                  << menuObject->name() << "\"));\n";
-            writeSetProperties( menuObject, "\t", "ac" );
-            out() << "\n";
+            return true;
         }
+    }
+
+    return false;
+}
 
-        foreach( HICObject* damObject, uiObject->content( HACO_DynamicActionMerger ) )
+/**
+ * @brief       Write the calls adding the content of a container through the lazy accessors
+ */
+void HIGenSource::writeLazyContent( HICObject* obj, const QString& member )
+{
+    foreach( HICObject* child, obj->content() )
+    {
+        const HIGenObjectKind* childKind = kindOf( child->type() );
+
+        if( child->type() == HACO_Separator )
         {
-            out() << "\tdam" << damObject->name() << " = new Heaven::DynamicActionMerger( parent );\n"
-                  << "\tdam" << damObject->name() << "->setObjectName(QString::fromUtf8(\"dam"
-                  << damObject->name() << "\"));\n";
-            writeSetProperties( damObject, "\t", "dam" );
-            out() << "\n";
+            out() << "\t\t" << member << "->addSeparator();\n";
         }
+        else if( childKind && child->type() != HACO_MenuBar && child->type() != HACO_ToolBar )
+        {
+            out() << "\t\t" << member << "->add( " << childKind->mPrefix << child->name()
+                  << "() );\n";
+        }
+    }
+}
+
+/**
+ * @brief       Write a Ui that creates its objects on first use
+ *
+ * setupActions() only remembers the parent. Each object gets an accessor that creates it on the
+ * first call. The content of containers is not created together with the container; instead the
+ * container gets a content provider, which adds the content once the container is shown for the
+ * first time. So the objects in menus that are never opened are never created.
+ *
+ */
+void HIGenSource::writeLazySetup( HICObject* uiObject )
+{
+    QString ui = uiObject->name();
+    HICObjects deferred;
+
+    out() << ui << "::" << ui << "()\n"
+             "\t: mParent( NULL )\n";
 
-        out() << "\t//Give containers some content\n\n";
+    for( int k = 0; k < HIGenObjectKindCount; k++ )
+    {
+        const HIGenObjectKind& kind = HIGenObjectKinds[ k ];
 
-        foreach( HICObject* object, uiObject->content() )
+        foreach( HICObject* obj, uiObject->content( kind.mType ) )
         {
-            const char* prefix = "";
-            switch( object->type() )
+            if( hasDeferredContent( obj ) )
             {
-            case HACO_Invalid:
-            case HACO_Action:
-            case HACO_MergePlace:
-            case HACO_Ui:
-            case HACO_Separator:
-            case HACO_WidgetAction:
-            case HACO_DynamicActionMerger:
+                // A QPointer, which is initialized anyway
+                deferred.append( obj );
                 continue;
+            }
 
-            case HACO_ActionGroup:
-                prefix = "\tagrp";
-                break;
+            out() << "\t, " << kind.mMember << obj->name() << "( NULL )\n";
+        }
+    }
 
-            case HACO_Menu:
-                prefix = "\tmenu";
-                break;
+    out() << "{\n"
+             "}\n"
+             "\n";
 
-            case HACO_MenuBar:
-                prefix = "\tmb";
-                break;
+    out() << ui << "::~" << ui << "()\n"
+             "{\n";
 
-            case HACO_ToolBar:
-                prefix = "\ttb";
-                break;
+    if( !deferred.isEmpty() )
+    {
+        out() << "\t// Containers that were never shown would still call back into us\n";
+    }
 
-            case HACO_Container:
-                prefix = "\tac";
-                break;
+    foreach( HICObject* obj, deferred )
+    {
+        QString member = QLatin1String( kindOf( obj->type() )->mMember ) + obj->name();
+
+        out() << "\tif( " << member << " )\n"
+                 "\t{\n"
+                 "\t\t" << member << "->setContentProvider( NULL, NULL );\n"
+                 "\t}\n";
+    }
+
+    out() << "}\n"
+             "\n";
+
+    QList< HICMergeRoute > routes = findMergeRoutes( uiObject );
+    writeMergeRouteTable( uiObject, routes );
+
+    out() << "void " << ui << "::setupActions( QObject* parent )\n"
+             "{\n"
+             "\tmParent = parent;\n";
+
+    if( !routes.isEmpty() )
+    {
+        // Merged containers have to exist right away; their content is still deferred
+        out() << "\n";
+        writeMergeRoutes( uiObject, routes, "()" );
+    }
+
+    out() << "}\n"
+             "\n";
+
+    for( int k = 0; k < HIGenObjectKindCount; k++ )
+    {
+        const HIGenObjectKind& kind = HIGenObjectKinds[ k ];
+
+        foreach( HICObject* obj, uiObject->content( kind.mType ) )
+        {
+            QString member = QLatin1String( kind.mMember ) + obj->name();
+
+            out() << "Heaven::" << kind.mClass << "* " << ui << "::" << kind.mPrefix << obj->name()
+                  << "()\n"
+                     "{\n"
+                     "\tif( !" << member << " )\n"
+                     "\t{\n"
+                     "\t\tQObject* parent = mParent;\n"
+                     "\t\tHeaven::UiObjectArena::Scope arenaScope( mUiObjectArena );\n"
+                     "\n"
+                     "\t\t" << member << " = new Heaven::" << kind.mClass << "( parent );\n";
+
+            if( obj->type() == HACO_MergePlace )
+            {
+                out() << "\t\t" << member << "->setName( QByteArray( \""
+                      << latin1Encode( obj->name() ) << "\" ) );\n";
             }
 
-            foreach( HICObject* child, object->content() )
+            out() << "\t\t" << member << "->setObjectName(QString::fromUtf8(\"" << kind.mPrefix
+                  << obj->name() << "\"));\n";
+
+            writeSetProperties( obj, "\t\t", kind.mMember );
+
+            if( obj->type() == HACO_ActionGroup )
             {
-                switch( child->type() )
-                {
-                case HACO_Separator:
-                    out() << prefix << object->name() << "->addSeparator();\n";
-                    break;
-
-                case HACO_Action:
-                    out() << prefix << object->name() << "->add( act" << child->name() << " );\n";
-                    break;
-
-                case HACO_ActionGroup:
-                    out() << prefix << object->name() << "->add( agrp" << child->name() << " );\n";
-                    break;
-
-                case HACO_WidgetAction:
-                    out() << prefix << object->name() << "->add( wac" << child->name() << " );\n";
-                    break;
-
-                case HACO_Container:
-                    out() << prefix << object->name() << "->add( ac" << child->name() << " );\n";
-                    break;
-
-                case HACO_MergePlace:
-                    out() << prefix << object->name() << "->add( mp" << child->name() << " );\n";
-                    break;
-
-                case HACO_Menu:
-                    out() << prefix << object->name() << "->add( menu" << child->name() << " );\n";
-                    break;
-
-                case HACO_DynamicActionMerger:
-                    out() << prefix << object->name() << "->add( dam" << child->name() << " );\n";
-                    break;
-
-                case HACO_ToolBar:
-                case HACO_MenuBar:
-                case HACO_Invalid:
-                case HACO_Ui:
-                    break;
-                }
+                // Not deferred; see hasDeferredContent()
+                writeLazyContent( obj, member );
             }
 
-            out() << "\n";
+            if( hasDeferredContent( obj ) )
+            {
+                QSet< HICObject* > visited;
+
+                out() << "\t\t" << member << "->setContentProvider( &" << ui
+                      << "::contentProvider, this, "
+                      << ( containsShortcuts( obj, visited ) ? "true" : "false" ) << " );\n";
+            }
+
+            out() << "\t}\n"
+                     "\n"
+                     "\treturn " << member << ";\n"
+                     "}\n"
+                     "\n";
         }
+    }
 
-        out() << "}\n\n";
+    out() << "void " << ui << "::contentProvider( void* self, Heaven::UiObject* container )\n"
+             "{\n"
+             "\tstatic_cast< " << ui << "* >( self )->fillContainer( container );\n"
+             "}\n"
+             "\n";
+
+    out() << "void " << ui << "::fillContainer( Heaven::UiObject* container )\n"
+             "{\n"
+             "\tHeaven::UiObjectArena::Scope arenaScope( mUiObjectArena );\n"
+             "\n";
+
+    bool first = true;
+    foreach( HICObject* obj, deferred )
+    {
+        QString member = QLatin1String( kindOf( obj->type() )->mMember ) + obj->name();
+
+        out() << ( first ? "\tif( " : "\telse if( " ) << "container == " << member << ".data() )\n"
+                 "\t{\n";
+        first = false;
+
+        writeLazyContent( obj, member );
+
+        out() << "\t}\n";
     }
 
-    return true;
+    out() << "}\n"
+             "\n";
 }
@@ -20,23 +20,37 @@
 #include <QSet>
 
 #include "HIGeneratorBase.h"
+#include "HICTable.h"
 
 class HIGenSource : public HIGeneratorBase
 {
 public:
-    HIGenSource( const HIDModel& model, const QString& fileName, const QString& baseName );
+    HIGenSource( const HIDModel& model, const QString& fileName, const QString& baseName,
+                 HIGenSetupMode mode = SetupImperative );
 
 protected:
     bool run();
 
 private:
     void writeActionConnect( HICObject* obj, const char* whitespace, const char* prefix );
+    bool writePreParsed( HICObject* obj, const QString& pname, const HICProperty& p,
+                         const char* whitespace, const char* prefix );
     void writeSetProperties( HICObject* obj, const char* whitespace, const char* prefix );
     void findIncludes();
+    void writeImperativeSetup( HICObject* uiObject );
+    bool writeTableSetup( HICObject* uiObject, const QString& ctx );
+    void writeLazySetup( HICObject* uiObject );
+    void writeLazyContent( HICObject* obj, const QString& member );
+    void writeTable( const char* type, const QString& name, const QStringList& rows );
+    void writeMergeRouteTable( HICObject* uiObject, const QList< HICMergeRoute >& routes );
+    void writeMergeRoutes( HICObject* uiObject, const QList< HICMergeRoute >& routes,
+                           const char* accessor );
 
 private:
     QString mBaseName;
     QSet< QString > mIncludes;
+    HIGenSetupMode mMode;
+    HICObject* mUiObject;
 };
 
 #endif
@@ -19,6 +19,21 @@
 
 #include "HIGeneratorBase.h"
 
+const HIGenObjectKind HIGenObjectKinds[] =
+{
+    { HACO_Action,              "Action",               "act",  "mAct"  },
+    { HACO_ActionGroup,         "ActionGroup",          "agrp", "mAgrp" },
+    { HACO_WidgetAction,        "WidgetAction",         "wac",  "mWac"  },
+    { HACO_MergePlace,          "MergePlace",           "mp",   "mMp"   },
+    { HACO_Menu,                "Menu",                 "menu", "mMenu" },
+    { HACO_MenuBar,             "MenuBar",              "mb",   "mMb"   },
+    { HACO_ToolBar,             "ToolBar",              "tb",   "mTb"   },
+    { HACO_Container,           "ActionContainer",      "ac",   "mAc"   },
+    { HACO_DynamicActionMerger, "DynamicActionMerger",  "dam",  "mDam"  }
+};
+
+const int HIGenObjectKindCount = int( sizeof( HIGenObjectKinds ) / sizeof( HIGenObjectKinds[ 0 ] ) );
+
 HIGeneratorBase::HIGeneratorBase( const HIDModel& model, const QString& fileName )
     : mModel( model )
     , mFileName( fileName )
@@ -59,19 +74,97 @@ QString HIGeneratorBase::utf8Encode( const QString& src )
     return result;
 }
 
+/**
+ * @brief       Run the generator and write its output
+ *
+ * The output is generated into memory first. The file is only written if its content actually
+ * changed, so that its time stamp stays untouched otherwise and nothing that includes it needs
+ * to be recompiled.
+ *
+ */
 bool HIGeneratorBase::generate()
 {
-    mOutFile.setFileName( mFileName );
-    if( !mOutFile.open( QFile::WriteOnly ) )
+    mOutText.clear();
+    mOutStream.setString( &mOutText, QIODevice::WriteOnly );
+
+    if( !run() )
     {
-        fprintf( stderr, "Cannot open %s for output.", qPrintable( mFileName ) );
-        exit( -1 );
+        return false;
     }
-    mOutStream.setDevice( &mOutFile );
-    mOutStream.setCodec( "UTF-8" );
-    return run();
+
+    return writeIfChanged( mFileName, output() );
 }
 
+/**
+ * @brief       Get the data to write into the output file
+ *
+ * @return      The text written to out(), in UTF-8. Generators that don't write text override
+ *              this.
+ *
+ */
+QByteArray HIGeneratorBase::output()
+{
+    mOutStream.flush();
+    return mOutText.toUtf8();
+}
+
+/**
+ * @brief       Write a file unless it already has the given content
+ *
+ * @return      `true` if the file has @a data as content now.
+ *
+ */
+bool HIGeneratorBase::writeIfChanged( const QString& fileName, const QByteArray& data )
+{
+    QFile outFile( fileName );
+
+    if( outFile.open( QFile::ReadOnly ) )
+    {
+        if( outFile.size() == data.size() && outFile.readAll() == data )
+        {
+            return true;
+        }
+        outFile.close();
+    }
+
+    if( !outFile.open( QFile::WriteOnly | QFile::Truncate ) )
+    {
+        fprintf( stderr, "Cannot open %s for output.\n", qPrintable( fileName ) );
+        return false;
+    }
+
+    return outFile.write( data ) == data.size();
+}
+
+/**
+ * @brief       Check whether a lazily generated Ui defers the content of an object
+ *
+ * @return      `true` if @a obj is a container with content. With `--lazy`, that content is only
+ *              created when the container is shown for the first time.
+ *
+ * ActionGroups are not deferred: Their actions are usually shown in menus and tool bars on their
+ * own, without the group ever being emerged. Those actions must still be part of the group.
+ *
+ */
+bool HIGeneratorBase::hasDeferredContent( HICObject* obj )
+{
+    switch( obj->type() )
+    {
+    case HACO_Menu:
+    case HACO_MenuBar:
+    case HACO_ToolBar:
+    case HACO_Container:
+        return !obj->content().isEmpty();
+
+    default:
+        return false;
+    }
+}
+
+QString HIGeneratorBase::fileName() const
+{
+    return mFileName;
+}
 
 const HIDModel& HIGeneratorBase::model() const
 {
@@ -23,6 +23,25 @@
 
 #include "HICObject.h"
 
+enum HIGenSetupMode
+{
+    SetupImperative,
+    SetupTables,
+    SetupLazy
+};
+
+struct HIGenObjectKind
+{
+    ObjectTypes mType;
+    const char* mClass;
+    const char* mPrefix;
+    const char* mMember;
+};
+
+// The kinds of objects a Ui has members for, in the order they are created in
+extern const HIGenObjectKind HIGenObjectKinds[];
+extern const int HIGenObjectKindCount;
+
 class HIGeneratorBase
 {
 public:
@@ -31,19 +50,25 @@ public:
 public:
     bool generate();
 
+    static bool writeIfChanged( const QString& fileName, const QByteArray& data );
+
 protected:
     QTextStream& out();
     const HIDModel& model() const;
+    QString fileName() const;
 
     QString latin1Encode( const QString& src );
     QString utf8Encode( const QString& src );
 
+    static bool hasDeferredContent( HICObject* obj );
+
     virtual bool run() = 0;
+    virtual QByteArray output();
 
 private:
     const HIDModel& mModel;
     QString         mFileName;
-    QFile           mOutFile;
+    QString         mOutText;
     QTextStream     mOutStream;
 };
 
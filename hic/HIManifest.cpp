@@ -0,0 +1,272 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "HIManifest.h"
+#include "HICObject.h"
+#include "HICTable.h"
+#include "HIGeneratorBase.h"
+
+namespace HIManifest
+{
+
+    static QByteArray quote( const QString& text )
+    {
+        QByteArray utf8 = text.toUtf8();
+        QByteArray result;
+        result.reserve( utf8.count() + 2 );
+        result += '"';
+
+        for( int i = 0; i < utf8.count(); i++ )
+        {
+            unsigned char c = utf8[ i ];
+            switch( c )
+            {
+            case '"':   result += "\\\"";  break;
+            case '\\':  result += "\\\\";  break;
+            case '\n':  result += "\\n";   break;
+            case '\r':  result += "\\r";   break;
+            case '\t':  result += "\\t";   break;
+
+            default:
+                if( c < 0x20 )
+                {
+                    result += "\\u00";
+                    result += QByteArray::number( c, 16 ).rightJustified( 2, '0' );
+                }
+                else
+                {
+                    result += char( c );
+                }
+                break;
+            }
+        }
+
+        result += '"';
+        return result;
+    }
+
+    static QByteArray quote( const char* text )
+    {
+        return quote( QString::fromLatin1( text ) );
+    }
+
+    static QByteArray list( const QList< QByteArray >& items, const char* indent )
+    {
+        if( items.isEmpty() )
+        {
+            return "[]";
+        }
+
+        QByteArray result = "[\n";
+        for( int i = 0; i < items.count(); i++ )
+        {
+            result += indent;
+            result += "    ";
+            result += items[ i ];
+            result += i + 1 < items.count() ? ",\n" : "\n";
+        }
+        result += indent;
+        result += "]";
+
+        return result;
+    }
+
+    static QByteArray stringProperty( HICObject* obj, const char* name )
+    {
+        QString pname = QLatin1String( name );
+
+        if( !obj->hasProperty( pname, HICP_String ) )
+        {
+            return "null";
+        }
+
+        return quote( obj->getProperty( pname ).value().toString() );
+    }
+
+    static QByteArray uiEntry( HICObject* uiObject )
+    {
+        QList< QByteArray > objects, mergePlaces, connections, mergers, mergeRoutes;
+
+        for( int k = 0; k < HIGenObjectKindCount; k++ )
+        {
+            const HIGenObjectKind& kind = HIGenObjectKinds[ k ];
+
+            foreach( HICObject* obj, uiObject->content( kind.mType ) )
+            {
+                QString member = QLatin1String( kind.mPrefix ) + obj->name();
+
+                objects << "{ \"name\": " + quote( obj->name() ) +
+                           ", \"type\": " + quote( kind.mClass ) +
+                           ", \"member\": " + quote( member ) + " }";
+
+                QString slot;
+                QByteArray receiver;
+
+                switch( kind.mType )
+                {
+                case HACO_MergePlace:
+                    mergePlaces << quote( obj->name() );
+                    break;
+
+                case HACO_Action:
+                    if( findActionConnect( obj, slot, receiver ) )
+                    {
+                        connections << "{ \"object\": " + quote( member ) +
+                                       ", \"signal\": " +
+                                       quote( isToggleSlot( slot ) ? "toggled(bool)"
+                                                                   : "triggered()" ) +
+                                       ", \"receiver\": " + quote( QString::fromUtf8( receiver ) ) +
+                                       ", \"receiverType\": " +
+                                       quote( findReceiverType( uiObject, obj, receiver ) ) +
+                                       ", \"slot\": " + quote( slot ) + " }";
+                    }
+                    break;
+
+                case HACO_DynamicActionMerger:
+                    mergers << "{ \"object\": " + quote( member ) +
+                               ", \"slot\": " + stringProperty( obj, "Merger" ) +
+                               ", \"rebuildSignal\": " + stringProperty( obj, "Rebuild" ) +
+                               " }";
+                    break;
+
+                default:
+                    break;
+                }
+            }
+        }
+
+        foreach( const HICMergeRoute& route, findMergeRoutes( uiObject ) )
+        {
+            mergeRoutes << "{ \"container\": " +
+                           quote( QLatin1String( "ac" ) + route.mContainer->name() ) +
+                           ", \"mergePlace\": " + quote( route.mMergePlace ) +
+                           ", \"priority\": " + QByteArray::number( route.mPriority ) + " }";
+        }
+
+        const char* indent = "                    ";
+
+        return "{\n"
+               "                    \"name\": " + quote( uiObject->name() ) + ",\n"
+               "                    \"objects\": " + list( objects, indent ) + ",\n"
+               "                    \"mergePlaces\": " + list( mergePlaces, indent ) + ",\n"
+               "                    \"connections\": " + list( connections, indent ) + ",\n"
+               "                    \"mergers\": " + list( mergers, indent ) + ",\n"
+               "                    \"mergeRoutes\": " + list( mergeRoutes, indent ) + "\n"
+               "                }";
+    }
+
+    /**
+     * @brief       Describe one compiled file
+     *
+     * @param[in]   model       The parsed file.
+     *
+     * @param[in]   input       The name of the .hid file.
+     *
+     * @param[in]   outputs     The files generated from it.
+     *
+     * @return      A JSON object to pass to document().
+     *
+     */
+    QByteArray fileEntry( const HIDModel& model, const QString& input,
+                          const QStringList& outputs )
+    {
+        QList< QByteArray > outputItems, uis;
+
+        foreach( QString output, outputs )
+        {
+            outputItems << quote( output );
+        }
+
+        foreach( HICObject* uiObject, model.allObjects( HACO_Ui ) )
+        {
+            uis << uiEntry( uiObject );
+        }
+
+        return "{\n"
+               "            \"input\": " + quote( input ) + ",\n"
+               "            \"outputs\": " + list( outputItems, "            " ) + ",\n"
+               "            \"uis\": " + list( uis, "            " ) + "\n"
+               "        }";
+    }
+
+    QByteArray document( const QList< QByteArray >& fileEntries )
+    {
+        return "{\n"
+               "    \"version\": 1,\n"
+               "    \"files\": " + list( fileEntries, "    " ) + "\n"
+               "}\n";
+    }
+
+    static QByteArray escapePath( const QString& path )
+    {
+        QByteArray result;
+
+        foreach( char c, path.toLocal8Bit() )
+        {
+            switch( c )
+            {
+            case ' ':
+            case '#':
+                result += '\\';
+                result += c;
+                break;
+
+            case '$':
+                result += "$$";
+                break;
+
+            default:
+                result += c;
+                break;
+            }
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief       Write a depfile
+     *
+     * .hid files don't include each other; objects of other files, like merge places, are only
+     * referred to by name at runtime. So the outputs of hic depend on nothing but their inputs.
+     *
+     */
+    QByteArray depfile( const QStringList& outputs, const QStringList& inputs )
+    {
+        QByteArray result;
+
+        foreach( QString output, outputs )
+        {
+            if( !result.isEmpty() )
+            {
+                result += " \\\n  ";
+            }
+            result += escapePath( output );
+        }
+
+        result += ":";
+
+        foreach( QString input, inputs )
+        {
+            result += " \\\n  " + escapePath( input );
+        }
+
+        result += "\n";
+        return result;
+    }
+
+}
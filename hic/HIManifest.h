@@ -0,0 +1,47 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef HI_MANIFEST_H
+#define HI_MANIFEST_H
+
+#include <QByteArray>
+#include <QStringList>
+
+class HIDModel;
+
+/**
+ * @brief       Machine readable descriptions of what hic compiled
+ *
+ * A manifest is a JSON document listing the objects, merge places and connections of each Ui of
+ * each compiled file. It lets tools check merge place names and slots without compiling any C++.
+ *
+ * A depfile lists the outputs and the input they were generated from in Makefile syntax, as
+ * expected by Ninja and Make.
+ *
+ */
+namespace HIManifest
+{
+
+    QByteArray fileEntry( const HIDModel& model, const QString& input,
+                          const QStringList& outputs );
+    QByteArray document( const QList< QByteArray >& fileEntries );
+
+    QByteArray depfile( const QStringList& outputs, const QStringList& inputs );
+
+}
+
+#endif
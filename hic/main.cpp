@@ -19,58 +19,337 @@
 #include <QCoreApplication>
 #include <QStringList>
 #include <QFileInfo>
+#include <QFile>
+#include <QTextStream>
+#include <QtConcurrentMap>
 
 #include "HICObject.h"
+#include "HICProperty.h"
 #include "HIDLexer.h"
 #include "HIDParser.h"
 #include "HIGenHeader.h"
 #include "HIGenSource.h"
+#include "HIGenBinary.h"
+#include "HIManifest.h"
 
-int main( int argc, char** argv )
+struct HicJob
+{
+    QString         mInput;
+    QString         mHeader;
+    QString         mSource;
+    QString         mBinary;        // With --binary, the only output
+    HIGenSetupMode  mMode;
+    bool            mWantManifest;
+
+    bool            mSuccess;
+    QByteArray      mManifest;
+
+    QStringList outputs() const
+    {
+        return mBinary.isEmpty() ? QStringList() << mHeader << mSource
+                                 : QStringList() << mBinary;
+    }
+};
+
+static bool parseInput( const QString& input, HIDModel& model )
+{
+    HIDTokenStream tokenStream;
+
+    QFile fInput( input );
+    if( !fInput.open( QFile::ReadOnly ) )
+    {
+        fprintf( stderr, "Cannot read from %s\n", qPrintable( input ) );
+        return false;
+    }
+
+    if( !HIDLexer::lex( fInput, tokenStream ) )
+    {
+        fprintf( stderr, "Could not tokenize input from %s\n", qPrintable( input ) );
+        return false;
+    }
+
+    if( !HIDParser::parse( tokenStream, model ) )
+    {
+        fprintf( stderr, "Could not parse input from %s\n", qPrintable( input ) );
+        return false;
+    }
+
+    return true;
+}
+
+static bool compile( HicJob& job )
 {
-    QCoreApplication app( argc, argv );
-    HIDTokenStream mTokenStream;
     HIDModel model;
 
+    if( !parseInput( job.mInput, model ) )
+    {
+        return false;
+    }
+
+    if( !job.mBinary.isEmpty() )
+    {
+        HIGenBinary genBinary( model, job.mBinary );
+        if( !genBinary.generate() )
+        {
+            fprintf( stderr, "Could not generate %s\n", qPrintable( job.mBinary ) );
+            return false;
+        }
+    }
+    else
+    {
+        HIGenHeader genHeader( model, job.mHeader, job.mMode );
+        if( !genHeader.generate() )
+        {
+            fprintf( stderr, "Could not generate %s\n", qPrintable( job.mHeader ) );
+            return false;
+        }
+
+        HIGenSource genSource( model, job.mSource, QFileInfo( job.mHeader ).fileName(),
+                               job.mMode );
+        if( !genSource.generate() )
+        {
+            fprintf( stderr, "Could not generate %s\n", qPrintable( job.mSource ) );
+            return false;
+        }
+    }
+
+    if( job.mWantManifest )
+    {
+        job.mManifest = HIManifest::fileEntry( model, job.mInput, job.outputs() );
+    }
+
+    return true;
+}
+
+static void runJob( HicJob& job )
+{
+    job.mSuccess = compile( job );
+}
+
+/**
+ * @brief       Write the manifest of all jobs
+ *
+ * @return      `true` if all jobs succeeded and the manifest was written.
+ *
+ */
+static bool writeManifest( const QString& fileName, const QList< HicJob >& jobs )
+{
+    QList< QByteArray > entries;
+
+    foreach( const HicJob& job, jobs )
+    {
+        if( !job.mSuccess )
+        {
+            return false;
+        }
+        entries << job.mManifest;
+    }
+
+    return HIGeneratorBase::writeIfChanged( fileName, HIManifest::document( entries ) );
+}
+
+/**
+ * @brief       Read the jobs of a batch run
+ *
+ * Each line of the list file names one job as `<input>\t<output-header>\t<output-source>`.
+ * Empty lines are ignored.
+ *
+ */
+static bool readJobs( const QString& listFile, const HicJob& proto, QList< HicJob >& jobs )
+{
+    QFile f( listFile );
+    if( !f.open( QFile::ReadOnly ) )
+    {
+        fprintf( stderr, "Cannot read from %s\n", qPrintable( listFile ) );
+        return false;
+    }
+
+    QTextStream ts( &f );
+    ts.setCodec( "UTF-8" );
+
+    int lineNo = 0;
+    while( !ts.atEnd() )
+    {
+        QString line = ts.readLine();
+        lineNo++;
+
+        if( line.trimmed().isEmpty() )
+        {
+            continue;
+        }
+
+        QStringList parts = line.split( QLatin1Char( '\t' ) );
+        if( parts.count() != 3 )
+        {
+            fprintf( stderr, "%s:%i: Expected <input>, <output-header> and <output-source>\n",
+                     qPrintable( listFile ), lineNo );
+            return false;
+        }
+
+        HicJob job = proto;
+        job.mInput = parts[ 0 ];
+        job.mHeader = parts[ 1 ];
+        job.mSource = parts[ 2 ];
+        jobs.append( job );
+    }
+
+    return true;
+}
+
+static void usage( const QStringList& args )
+{
+    QByteArray self = args.count() ? args[ 0 ].toLocal8Bit() : QByteArray( "hic" );
+
+    fprintf( stderr, "Usage: %s [options] <input> <output-header> <output-source>\n"
+                     "       %s [options] --batch <list-file>\n"
+                     "       %s [options] --binary <input> <output>\n"
+                     "\n"
+                     "  --tables             Describe the Uis in static tables that are\n"
+                     "                       instantiated by Heaven::UiBuilder, instead of\n"
+                     "                       generating code for each object.\n"
+                     "  --lazy               Generate accessors that create each object on first\n"
+                     "                       use. The content of a container is created when it\n"
+                     "                       is shown first.\n"
+                     "  --binary             Write the Uis into a binary file that\n"
+                     "                       Heaven::UiLoader loads at runtime.\n"
+                     "  --depfile <file>     Write the dependencies of the outputs in Makefile\n"
+                     "                       syntax (not with --batch).\n"
+                     "  --manifest <file>    Write the objects, merge places and connections of\n"
+                     "                       all Uis as JSON.\n",
+             self.constData(), self.constData(), self.constData() );
+}
+
+int main( int argc, char** argv )
+{
+    QCoreApplication app( argc, argv );
     QStringList sl = QCoreApplication::arguments();
 
-    if( sl.count() != 4 )
+    // Static tables are filled lazily; make sure that happens before any threads are running.
+    HICPropertyDefs::init();
+
+    HicJob job;
+    job.mMode = SetupImperative;
+    job.mWantManifest = false;
+    job.mSuccess = false;
+
+    bool binary = false;
+    QString listFile, depFile, manifestFile;
+    QStringList files;
+
+    for( int i = 1; i < sl.count(); i++ )
     {
-        fprintf( stderr, "Usage: %s <input> <output-header> <output-source>\n",
-                 sl.count() ? qPrintable( sl[ 0 ] ) : "" );
-        return -1;
+        QString arg = sl[ i ];
+
+        if( arg == QLatin1String( "--tables" ) )
+        {
+            job.mMode = SetupTables;
+        }
+        else if( arg == QLatin1String( "--lazy" ) )
+        {
+            job.mMode = SetupLazy;
+        }
+        else if( arg == QLatin1String( "--binary" ) )
+        {
+            binary = true;
+        }
+        else if( arg == QLatin1String( "--batch" ) ||
+                 arg == QLatin1String( "--depfile" ) ||
+                 arg == QLatin1String( "--manifest" ) )
+        {
+            if( ++i == sl.count() )
+            {
+                usage( sl );
+                return -1;
+            }
+
+            if( arg == QLatin1String( "--batch" ) )
+            {
+                listFile = sl[ i ];
+            }
+            else if( arg == QLatin1String( "--depfile" ) )
+            {
+                depFile = sl[ i ];
+            }
+            else
+            {
+                manifestFile = sl[ i ];
+            }
+        }
+        else
+        {
+            files << arg;
+        }
     }
 
-    QFile fInput( sl[ 1 ] );
-    if( !fInput.open( QFile::ReadOnly ) )
+    job.mWantManifest = !manifestFile.isEmpty();
+
+    if( !listFile.isEmpty() )
     {
-        fprintf( stderr, "Cannot read from %s\n", qPrintable( sl[ 1 ] ) );
-        return -1;
+        if( binary || !depFile.isEmpty() || !files.isEmpty() )
+        {
+            usage( sl );
+            return -1;
+        }
+
+        QList< HicJob > jobs;
+        if( !readJobs( listFile, job, jobs ) )
+        {
+            return -1;
+        }
+
+        QtConcurrent::blockingMap( jobs, runJob );
+
+        if( job.mWantManifest )
+        {
+            return writeManifest( manifestFile, jobs ) ? 0 : -1;
+        }
+
+        foreach( const HicJob& done, jobs )
+        {
+            if( !done.mSuccess )
+            {
+                return -1;
+            }
+        }
+
+        return 0;
     }
 
-    if( !HIDLexer::lex( fInput, mTokenStream ) )
+    if( files.count() != ( binary ? 2 : 3 ) )
     {
-        fprintf( stderr, "Could not tokenize input from %s\n", qPrintable( sl[ 1 ] ) );
+        usage( sl );
         return -1;
     }
 
-    if( !HIDParser::parse( mTokenStream, model ) )
+    job.mInput = files[ 0 ];
+    if( binary )
     {
-        fprintf( stderr, "Could not parse input from %s\n", qPrintable( sl[ 1 ] ) );
-        return -1;
+        job.mBinary = files[ 1 ];
+    }
+    else
+    {
+        job.mHeader = files[ 1 ];
+        job.mSource = files[ 2 ];
     }
 
-    HIGenHeader genHeader( model, sl[ 2 ] );
-    if( !genHeader.generate() )
+    runJob( job );
+    if( !job.mSuccess )
     {
-        fprintf( stderr, "Could not generate %s\n", qPrintable( sl[ 2 ] ) );
         return -1;
     }
 
-    HIGenSource genSource( model, sl[ 3 ], QFileInfo( sl[ 2 ] ).fileName() );
-    if( !genSource.generate() )
+    if( !depFile.isEmpty() )
+    {
+        QByteArray deps = HIManifest::depfile( job.outputs(), QStringList() << job.mInput );
+        if( !HIGeneratorBase::writeIfChanged( depFile, deps ) )
+        {
+            return -1;
+        }
+    }
+
+    if( job.mWantManifest &&
+        !writeManifest( manifestFile, QList< HicJob >() << job ) )
     {
-        fprintf( stderr, "Could not generate %s\n", qPrintable( sl[ 3 ] ) );
         return -1;
     }
 
@@ -15,10 +15,14 @@
  */
 
 #include <QAction>
+#include <QMenu>
+#include <QStringBuilder>
 
 #include "libHeavenActions/ActionPrivate.hpp"
 #include "libHeavenActions/ActionGroup.hpp"
+#include "libHeavenActions/UiContainer.hpp"
 #include "libHeavenActions/UiManager.hpp"
+#include "libHeavenActions/ActionTracingPrivate.hpp"
 
 namespace Heaven
 {
@@ -29,128 +33,127 @@ namespace Heaven
         , mEnabled( true )
         , mCheckable( false )
         , mChecked( false )
+        , mStateDirty( false )
         , mShortcutContext( Qt::WindowShortcut )
         , mMenuRole( QAction::TextHeuristicRole )
         , mGroup(NULL)
+        , mDirtyProperties( 0 )
     {
+        UiManager::self()->actionIndex()->addAction( this );
     }
 
     ActionPrivate::~ActionPrivate()
     {
+        // Leave the containers while we are still an ActionPrivate, so the index can tell.
+        foreach( UiContainer* container, mContainers )
+        {
+            removeFromContainer( container );
+        }
+
+        UiManager::self()->actionIndex()->removeAction( this );
+        UiManager::self()->cancelActionUpdate( this );
     }
 
     void ActionPrivate::setText( const QString& text )
     {
         mText = text;
-
-        foreach( QAction* act, mQActions )
-        {
-            act->setText( text );
-        }
+        propertiesChanged( DirtyText );
+        UiManager::self()->actionIndex()->invalidate( this );
     }
 
     void ActionPrivate::setStatusTip( const QString& text )
     {
         mStatusTip = text;
-
-        foreach( QAction* act, mQActions )
-        {
-            act->setStatusTip( text );
-        }
+        propertiesChanged( DirtyStatusTip );
     }
 
     void ActionPrivate::setToolTip( const QString& text )
     {
         mToolTip = text;
-
-        foreach( QAction* act, mQActions )
-        {
-            act->setToolTip( text );
-        }
+        propertiesChanged( DirtyToolTip );
+        UiManager::self()->actionIndex()->invalidate( this );
     }
 
     void ActionPrivate::setEnabled( bool v )
     {
         mEnabled = v;
-
-        foreach( QAction* act, mQActions )
-        {
-            act->setEnabled( v );
-        }
+        propertiesChanged( DirtyEnabled );
     }
 
     void ActionPrivate::setChecked( bool v )
     {
         mChecked = v;
-
-        foreach( QAction* act, mQActions )
-        {
-            act->setChecked( v );
-        }
+        propertiesChanged( DirtyChecked );
     }
 
     void ActionPrivate::setCheckable( bool v )
     {
         mCheckable = v;
-
-        foreach( QAction* act, mQActions )
-        {
-            act->setCheckable( v );
-        }
+        propertiesChanged( DirtyCheckable );
     }
 
     void ActionPrivate::setVisible( bool v )
     {
         mVisible = v;
-
-        foreach( QAction* act, mQActions )
-        {
-            act->setVisible( v );
-        }
+        propertiesChanged( DirtyVisible );
     }
 
     void ActionPrivate::setIconRef( const IconRef& ref )
     {
         mIconRef = ref;
         mIcon = QIcon();
-        updateIcons();
+        propertiesChanged( DirtyIcon );
     }
 
     void ActionPrivate::setShortcut(const QString &shortcut)
     {
-        mShortcut = QKeySequence::fromString(shortcut);
+        setShortcut( QKeySequence::fromString( shortcut ) );
+    }
+
+    void ActionPrivate::setShortcut( const QKeySequence& shortcut )
+    {
+        mShortcut = shortcut;
+        propertiesChanged( DirtyShortcut );
 
-        foreach( QAction *act, mQActions )
+        foreach( UiContainer* container, mContainers )
         {
-            act->setShortcut( mShortcut );
+            if( mQActions.isEmpty() )
+            {
+                // We are only in menus that were never populated. Let them check again whether
+                // they have to be populated for the shortcut to work.
+                container->setContainerDirty();
+            }
+            else
+            {
+                container->invalidateShortcuts();
+            }
         }
     }
 
     void ActionPrivate::setShortcutContext(Qt::ShortcutContext context)
     {
         mShortcutContext = context;
-
-        foreach( QAction *act, mQActions )
-        {
-            act->setShortcutContext( context );
-        }
+        propertiesChanged( DirtyShortcutContext );
     }
 
     void ActionPrivate::setMenuRole( QAction::MenuRole role )
     {
         mMenuRole = role;
-
-        foreach( QAction* act, mQActions )
-        {
-            // Will this actually move things around?
-            act->setMenuRole( role );
-        }
+        propertiesChanged( DirtyMenuRole );
     }
 
     void ActionPrivate::qactionDestroyed()
     {
         QAction* act = static_cast< QAction* >( sender() );
-        if( mQActions.remove( act ) )
+
+        QObject* forParent = act->parent();
+        if( mQActions.value( forParent ) != act )
+        {
+            // Someone reparented the QAction after we created it; search it the hard way.
+            forParent = mQActions.key( act, act );
+        }
+
+        if( mQActions.remove( forParent ) )
         {
             #if 0
             qDebug( "AC(%p) - QAction (%p) was removed", owner(), act );
@@ -164,11 +167,13 @@ namespace Heaven
             #endif
         }
 
+        UiManager::self()->unregisterShortcut( act );
         UiManager::self()->removeCreatedObject( act );
     }
 
     void ActionPrivate::qactionTriggered()
     {
+        HEAVEN_TRACE_SCOPE( trace, "trigger", "Action", mOwner );
         findActivationContext( sender() );
 
         emit triggered();
@@ -195,6 +200,12 @@ namespace Heaven
 
     QAction* ActionPrivate::createQAction( QObject* forParent )
     {
+        if( mStateDirty )
+        {
+            // Predicates are not evaluated for actions without QActions, so catch up now.
+            evaluateState();
+        }
+
         QAction* a = new QAction( forParent );
 
         a->setText( mText );
@@ -204,7 +215,6 @@ namespace Heaven
         a->setCheckable( mCheckable );
         a->setChecked( mChecked );
         a->setVisible( mVisible );
-        a->setShortcut( mShortcut );
         a->setShortcutContext( mShortcutContext );
         a->setMenuRole( mMenuRole );
 
@@ -218,7 +228,7 @@ namespace Heaven
         connect( a, SIGNAL(triggered()), this, SLOT(qactionTriggered()) );
         connect( a, SIGNAL(toggled(bool)), this, SLOT(qactionToggled(bool)) );
 
-        mQActions.insert( a );
+        mQActions.insert( forParent, a );
         #if 0
         qDebug( "AC(%p) - Created QAction(%p) for QWidget(%p)", owner(), a, forParent );
         #endif
@@ -228,20 +238,175 @@ namespace Heaven
         }
 
         UiManager::self()->addCreatedObject( a, this );
+        applyShortcut( a );
         return a;
     }
 
+    /**
+     * @internal
+     * @brief       Hand the shortcut of this action to a QAction
+     *
+     * Window shortcuts are dispatched by UiManager's shortcut index, so that an action merged into
+     * several widgets does not register the same key sequence over and over with Qt's shortcut
+     * map. Only if the index cannot take the shortcut, the QAction gets to register it on its own.
+     *
+     */
+    void ActionPrivate::applyShortcut( QAction* act )
+    {
+        UiManager::self()->unregisterShortcut( act );
+
+        if( UiManager::self()->registerShortcut( this, act ) )
+        {
+            act->setShortcut( QKeySequence() );
+        }
+        else
+        {
+            act->setShortcut( mShortcut );
+        }
+
+        act->setText( textFor( act ) );
+    }
+
+    /**
+     * @internal
+     * @brief       Get the text to show in a QAction
+     *
+     * QMenu displays the shortcut of a QAction in a column right of the text. For QActions whose
+     * shortcut is dispatched by the index, we have to tell it about the shortcut via the text.
+     *
+     */
+    QString ActionPrivate::textFor( QAction* act ) const
+    {
+        if( qobject_cast< QMenu* >( act->parent() ) && UiManager::self()->isShortcutTarget( act ) )
+        {
+            return mText % QLatin1Char( '\t' ) % mShortcut.toString( QKeySequence::NativeText );
+        }
+
+        return mText;
+    }
+
     QAction* ActionPrivate::getOrCreateQAction( QObject* forParent )
     {
+        QAction* act = mQActions.value( forParent, NULL );
+        if( act )
+        {
+            return act;
+        }
+
+        return createQAction( forParent );
+    }
+
+    /**
+     * @internal
+     * @brief       Trigger this action without a user interaction on one of its QActions
+     *
+     * If the action has QActions, one of them is triggered, so that the activation context is
+     * found just like for a click into a menu. Otherwise the action's own activation context is
+     * used.
+     *
+     */
+    void ActionPrivate::trigger()
+    {
+        if( mStateDirty )
+        {
+            evaluateState();
+        }
+
+        if( !mEnabled || !mVisible )
+        {
+            return;
+        }
+
         foreach( QAction* act, mQActions )
         {
-            if( act->parent() == forParent )
+            if( act->isEnabled() )
             {
-                return act;
+                act->trigger();
+                return;
             }
         }
 
-        return createQAction( forParent );
+        mActivatedBy = mActivationContext;
+
+        HEAVEN_TRACE_SCOPE( trace, "trigger", "Action", mOwner );
+
+        if( mCheckable )
+        {
+            setChecked( !mChecked );
+            emit toggled( mChecked );
+        }
+
+        emit triggered();
+    }
+
+    bool ActionPrivate::isMaterialized() const
+    {
+        return !mQActions.isEmpty();
+    }
+
+    /**
+     * @internal
+     * @brief       Mark the predicated state of this action as stale
+     *
+     * The predicates are not invoked right away. Instead, UiManager collects all stale actions
+     * and evaluates those that have QActions once per event loop iteration.
+     *
+     */
+    void ActionPrivate::invalidateState()
+    {
+        if( !mEnabledPredicate.mReceiver &&
+            !mVisiblePredicate.mReceiver &&
+            !mCheckedPredicate.mReceiver )
+        {
+            return;
+        }
+
+        mStateDirty = true;
+        UiManager::self()->invalidateActionState( this );
+    }
+
+    bool ActionPrivate::evaluatePredicate( const StatePredicate& predicate, bool& value )
+    {
+        if( !predicate.mReceiver || predicate.mMethod.isEmpty() )
+        {
+            return false;
+        }
+
+        bool result = false;
+        if( !QMetaObject::invokeMethod( predicate.mReceiver, predicate.mMethod.constData(),
+                                        Qt::DirectConnection,
+                                        Q_RETURN_ARG( bool, result ),
+                                        Q_ARG( Heaven::Action*,
+                                               static_cast< Action* >( mOwner ) ) ) )
+        {
+            qWarning( "Heaven::Action: Cannot invoke state predicate %s",
+                      predicate.mMethod.constData() );
+            return false;
+        }
+
+        value = result;
+        return true;
+    }
+
+    void ActionPrivate::evaluateState()
+    {
+        bool value;
+        mStateDirty = false;
+
+        if( evaluatePredicate( mEnabledPredicate, value ) && value != mEnabled )
+        {
+            setEnabled( value );
+        }
+
+        if( evaluatePredicate( mVisiblePredicate, value ) && value != mVisible )
+        {
+            setVisible( value );
+        }
+
+        if( evaluatePredicate( mCheckedPredicate, value ) && value != mChecked )
+        {
+            setChecked( value );
+        }
     }
 
     void ActionPrivate::createIcon()
@@ -252,15 +417,89 @@ namespace Heaven
         }
     }
 
-    void ActionPrivate::updateIcons()
+    /**
+     * @internal
+     * @brief       Record that properties changed and push them to the created QActions
+     *
+     * @param[in]   which   Combination of DirtyProperty flags that changed.
+     *
+     * While an ActionBatchUpdate is alive, the properties are only recorded. They are applied once
+     * per QAction when the outermost ActionBatchUpdate is destroyed.
+     *
+     */
+    void ActionPrivate::propertiesChanged( int which )
+    {
+        mDirtyProperties |= which;
+
+        if( UiManager::self()->isBatchingActions() )
+        {
+            UiManager::self()->queueActionUpdate( this );
+            return;
+        }
+
+        flushProperties();
+    }
+
+    void ActionPrivate::flushProperties()
     {
-        createIcon();
+        int which = mDirtyProperties;
+        mDirtyProperties = 0;
+
+        if( !which || mQActions.isEmpty() )
+        {
+            return;
+        }
+
+        if( which & DirtyIcon )
+        {
+            createIcon();
+        }
+
         foreach( QAction* act, mQActions )
         {
-            act->setIcon( mIcon );
+            applyProperties( act, which );
         }
     }
 
+    void ActionPrivate::applyProperties( QAction* act, int which )
+    {
+        if( which & DirtyText )
+            act->setText( textFor( act ) );
+
+        if( which & DirtyToolTip )
+            act->setToolTip( mToolTip );
+
+        if( which & DirtyStatusTip )
+            act->setStatusTip( mStatusTip );
+
+        if( which & DirtyEnabled )
+            act->setEnabled( mEnabled );
+
+        if( which & DirtyCheckable )
+            act->setCheckable( mCheckable );
+
+        if( which & DirtyChecked )
+            act->setChecked( mChecked );
+
+        if( which & DirtyVisible )
+            act->setVisible( mVisible );
+
+        if( which & DirtyIcon )
+            act->setIcon( mIcon );
+
+        if( which & DirtyShortcutContext )
+            act->setShortcutContext( mShortcutContext );
+
+        if( which & ( DirtyShortcut | DirtyShortcutContext ) )
+            applyShortcut( act );
+
+        if( which & DirtyMenuRole )
+            act->setMenuRole( mMenuRole );
+
+        if( which & ( DirtyEnabled | DirtyVisible ) )
+            UiManager::self()->refreshShortcut( act );
+    }
+
     UiObjectTypes ActionPrivate::type() const
     {
         return ActionType;
@@ -275,6 +514,19 @@ namespace Heaven
         connect( d, SIGNAL(toggled(bool)), this, SIGNAL(toggled(bool)) );
     }
 
+    /**
+     * @brief       Trigger this action
+     *
+     * Does the same as a click on one of the menu entries or tool buttons of this action. Nothing
+     * happens if the action is disabled or invisible.
+     *
+     */
+    void Action::trigger()
+    {
+        UIOD(Action);
+        d->trigger();
+    }
+
     QAction* Action::actionFor( QObject* parent )
     {
         UIOD(Action);
@@ -310,7 +562,7 @@ namespace Heaven
     QKeySequence Action::shortcut() const
     {
         UIOD(const Action);
-        return d->mShortcutContext;
+        return d->mShortcut;
     }
 
     Qt::ShortcutContext Action::shortcutContext() const
@@ -429,6 +681,21 @@ namespace Heaven
         d->setShortcut( shortcut );
     }
 
+    /**
+     * @brief       Set the shortcut from an already parsed key sequence
+     *
+     * @param[in]   shortcut    The key sequence to use.
+     *
+     * hic uses this for shortcuts it could parse at compile time, which saves the parsing of the
+     * string at runtime.
+     *
+     */
+    void Action::setShortcut( const QKeySequence& shortcut )
+    {
+        UIOD(Action);
+        d->setShortcut( shortcut );
+    }
+
     void Action::setShortcutContext(Qt::ShortcutContext context)
     {
         UIOD(Action);
@@ -452,4 +719,143 @@ namespace Heaven
         UIOD(const Action);
         return d->mGroup;
     }
+
+    /**
+     * @brief       Compute the enabled state through a predicate
+     *
+     * @param[in]   receiver    The object that implements the predicate.
+     *
+     * @param[in]   method      Name of a slot or `Q_INVOKABLE` method of @a receiver with the
+     *                          signature `bool method(Heaven::Action*)`. Pass `NULL` to remove
+     *                          the predicate.
+     *
+     * Instead of calling setEnabled() from many places, the enabled state can be described by a
+     * predicate. It is re-evaluated after invalidateState() was called or one of the signals
+     * registered through addStateDependency() was emitted.
+     *
+     * Evaluation is lazy: All invalidated actions are evaluated in one batch per event loop
+     * iteration, and only if they currently have QActions. Others are evaluated as soon as
+     * a QAction is created for them.
+     *
+     */
+    void Action::setEnabledPredicate( QObject* receiver, const char* method )
+    {
+        UIOD(Action);
+        d->mEnabledPredicate.mReceiver = receiver;
+        d->mEnabledPredicate.mMethod = method;
+        d->invalidateState();
+    }
+
+    /**
+     * @brief       Compute the visibility through a predicate
+     *
+     * @param[in]   receiver    The object that implements the predicate.
+     *
+     * @param[in]   method      Name of a method with the signature `bool method(Heaven::Action*)`.
+     *
+     * See setEnabledPredicate() for details.
+     *
+     */
+    void Action::setVisiblePredicate( QObject* receiver, const char* method )
+    {
+        UIOD(Action);
+        d->mVisiblePredicate.mReceiver = receiver;
+        d->mVisiblePredicate.mMethod = method;
+        d->invalidateState();
+    }
+
+    /**
+     * @brief       Compute the checked state through a predicate
+     *
+     * @param[in]   receiver    The object that implements the predicate.
+     *
+     * @param[in]   method      Name of a method with the signature `bool method(Heaven::Action*)`.
+     *
+     * See setEnabledPredicate() for details.
+     *
+     */
+    void Action::setCheckedPredicate( QObject* receiver, const char* method )
+    {
+        UIOD(Action);
+        d->mCheckedPredicate.mReceiver = receiver;
+        d->mCheckedPredicate.mMethod = method;
+        d->invalidateState();
+    }
+
+    /**
+     * @brief       Declare an input the predicates of this action depend on
+     *
+     * @param[in]   sender      The object that emits @a signal.
+     *
+     * @param[in]   signal      A Qt-encoded signal signature. Use the `SIGNAL()` macro.
+     *
+     * Whenever @a signal is emitted, the predicated state of this action is invalidated. Changes
+     * of this action's activation context always invalidate the state.
+     *
+     */
+    void Action::addStateDependency( QObject* sender, const char* signal )
+    {
+        UIOD(Action);
+        connect( sender, signal, d, SLOT(invalidateState()), Qt::UniqueConnection );
+    }
+
+    /**
+     * @brief       Request re-evaluation of the state predicates
+     *
+     * The predicates are not invoked synchronously. See setEnabledPredicate().
+     *
+     */
+    void Action::invalidateState()
+    {
+        UIOD(Action);
+        d->invalidateState();
+    }
+
+    /**
+     * @class       ActionBatchUpdate
+     * @ingroup     Actions
+     * @brief       Coalesce property changes of Actions
+     *
+     * Every property change of an Action is usually pushed to each QAction that was created for
+     * it right away. Each of these updates is propagated to all widgets the QAction is shown in.
+     *
+     * Code that updates the state of many actions at once (i.e. on a selection change) can create
+     * an ActionBatchUpdate on the stack. As long as at least one ActionBatchUpdate exists, Action
+     * property changes are only recorded. When the outermost one is destroyed, the final values
+     * are applied once per QAction and intermediate values never reach the widgets.
+     *
+     * @code
+     * {
+     *     Heaven::ActionBatchUpdate batch;
+     *     foreach( Heaven::Action* a, allActions )
+     *         a->setEnabled( isApplicable( a ) );
+     * }
+     * @endcode
+     *
+     * The getters of Action always return the new values, even while a batch is active.
+     *
+     */
+
+    /**
+     * @brief       Constructor
+     *
+     * Starts (or nests into) a batch of Action property updates.
+     *
+     */
+    ActionBatchUpdate::ActionBatchUpdate()
+    {
+        UiManager::self()->beginActionBatch();
+    }
+
+    /**
+     * @brief       Destructor
+     *
+     * Applies all recorded property changes, if this was the outermost ActionBatchUpdate.
+     *
+     */
+    ActionBatchUpdate::~ActionBatchUpdate()
+    {
+        UiManager::self()->endActionBatch();
+    }
+
 }
@@ -63,19 +63,39 @@ namespace Heaven
         void setIconRef( const QString& text );
         void setIconRef( const IconRef& ref );
         void setShortcut ( const QString & shortcut );
+        void setShortcut( const QKeySequence& shortcut );
         void setShortcutContext( Qt::ShortcutContext context );
         void setMenuRole( QAction::MenuRole role );
         void setVisible( bool visible );
         void setGroup(Heaven::ActionGroup *group);
 
+        void invalidateState();
+        void trigger();
+
     signals:
         void triggered();
         void toggled( bool checked );
 
+    public:
+        void setEnabledPredicate( QObject* receiver, const char* method );
+        void setVisiblePredicate( QObject* receiver, const char* method );
+        void setCheckedPredicate( QObject* receiver, const char* method );
+        void addStateDependency( QObject* sender, const char* signal );
+
     public:
         QAction* actionFor( QObject* parent );
     };
 
+    class HEAVEN_ACTIONS_API ActionBatchUpdate
+    {
+    public:
+        ActionBatchUpdate();
+        ~ActionBatchUpdate();
+
+    private:
+        Q_DISABLE_COPY( ActionBatchUpdate )
+    };
+
 }
 
 #endif
@@ -35,6 +35,7 @@ namespace Heaven
 
     ActionContainerPrivate::~ActionContainerPrivate()
     {
+        MergesManager::self()->unmergeContainer( this );
     }
 
     UiObjectTypes ActionContainerPrivate::type() const
@@ -70,6 +71,18 @@ namespace Heaven
         MergesManager::self()->mergeContainer( d, mergePlace );
     }
 
+    void ActionContainer::unmerge( const QByteArray& mergePlace )
+    {
+        UIOD(ActionContainer);
+        MergesManager::self()->unmergeContainer( d, mergePlace );
+    }
+
+    void ActionContainer::unmerge()
+    {
+        UIOD(ActionContainer);
+        MergesManager::self()->unmergeContainer( d );
+    }
+
     void ActionContainer::add( UiObject* uio )
     {
         UIOD(ActionContainer);
@@ -32,11 +32,14 @@ namespace Heaven
     class HEAVEN_ACTIONS_API ActionContainer : public UiObject
     {
         Q_OBJECT
+        friend class UiBuilder;
     public:
         ActionContainer( QObject* parent );
 
     public:
         void mergeInto( const QByteArray& mergePlace );
+        void unmerge( const QByteArray& mergePlace );
+        void unmerge();
 
     public slots:
         void setMergePriority( int priority );
@@ -55,6 +55,8 @@ namespace Heaven
             return grp;
         }
 
+        provideContent();
+
         grp = new QActionGroup(forParent);
         mCreatedGroups.insert(forParent, grp);
         // ^ Insert first, so recusion will take the sorted code path above.
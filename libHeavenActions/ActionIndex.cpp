@@ -0,0 +1,402 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+
+#include <QtAlgorithms>
+#include <QStringList>
+#include <QStringBuilder>
+
+#include "libHeavenActions/ActionIndex.hpp"
+#include "libHeavenActions/ActionPrivate.hpp"
+#include "libHeavenActions/MenuPrivate.hpp"
+#include "libHeavenActions/UiContainer.hpp"
+
+namespace Heaven
+{
+
+    /**
+     * @internal
+     * @class       ActionIndex
+     * @brief       Trigram index over the searchable texts of all actions
+     *
+     * Every ActionPrivate registers itself with the index owned by UiManager. For each action a
+     * document is built from its text, its tool tip and the path of menus it is reachable through.
+     * The index maps each trigram of the folded document text to the set of actions containing it.
+     *
+     * The index is maintained incrementally: Changes only mark the affected actions as dirty and
+     * dirty documents are rebuilt on the next query. If a menu is renamed or moved, that affects
+     * the menu path of the actions inside it, so those are marked dirty.
+     *
+     * A query with at least three characters only looks at actions sharing at least half of the
+     * query's trigrams, which tolerates typos and transposed characters. Shorter queries are
+     * matched as a subsequence against all documents.
+     *
+     */
+
+    struct ActionIndexHit
+    {
+        int             mScore;
+        QString         mTitle;
+        ActionPrivate*  mAction;
+
+        bool operator<( const ActionIndexHit& other ) const
+        {
+            if( mScore != other.mScore )
+            {
+                return mScore > other.mScore;
+            }
+
+            return mTitle < other.mTitle;
+        }
+    };
+
+    ActionIndex::ActionIndex()
+        : mAllDirty( false )
+    {
+    }
+
+    ActionIndex::~ActionIndex()
+    {
+    }
+
+    void ActionIndex::addAction( ActionPrivate* action )
+    {
+        mDocuments.insert( action, Document() );
+        mDirty.insert( action );
+    }
+
+    void ActionIndex::removeAction( ActionPrivate* action )
+    {
+        unindexDocument( action );
+        mDocuments.remove( action );
+        mDirty.remove( action );
+    }
+
+    /**
+     * @internal
+     * @brief       Mark the documents of an object as dirty
+     *
+     * @param[in]   uio     The object whose searchable text or position in the container
+     *                      hierarchy changed.
+     *
+     * If @a uio is a container, all actions inside it (at any depth) are marked dirty, since their
+     * menu path might have changed. Other objects, like separators or merge places, are not part
+     * of any menu path. Content that a content provider has yet to create is not indexed anyway.
+     *
+     */
+    void ActionIndex::invalidate( UiObjectPrivate* uio )
+    {
+        QSet< UiContainer* > visited;
+        invalidateBelow( uio, visited );
+    }
+
+    void ActionIndex::invalidateBelow( UiObjectPrivate* uio, QSet< UiContainer* >& visited )
+    {
+        if( mAllDirty )
+        {
+            return;
+        }
+
+        ActionPrivate* action = qobject_cast< ActionPrivate* >( uio );
+        if( action )
+        {
+            if( mDocuments.contains( action ) )
+            {
+                mDirty.insert( action );
+            }
+            return;
+        }
+
+        UiContainer* container = qobject_cast< UiContainer* >( uio );
+        if( !container || visited.contains( container ) )
+        {
+            return;
+        }
+        visited.insert( container );
+
+        foreach( UiObjectPrivate* child, container->mContent )
+        {
+            invalidateBelow( child, visited );
+        }
+    }
+
+    void ActionIndex::invalidateAll()
+    {
+        mAllDirty = true;
+    }
+
+    QString ActionIndex::fold( const QString& text )
+    {
+        QString folded = text;
+        folded.remove( QLatin1Char( '&' ) );
+        return folded.toLower().simplified();
+    }
+
+    static quint64 makeTrigram( QChar a, QChar b, QChar c )
+    {
+        return ( quint64( a.unicode() ) << 32 ) | ( quint64( b.unicode() ) << 16 ) | c.unicode();
+    }
+
+    QVector< ActionIndex::Trigram > ActionIndex::trigramsOf( const QString& text )
+    {
+        QVector< Trigram > result;
+
+        if( text.length() < 3 )
+        {
+            return result;
+        }
+
+        result.reserve( text.length() - 2 );
+        for( int i = 0; i + 2 < text.length(); i++ )
+        {
+            result.append( makeTrigram( text.at( i ), text.at( i + 1 ), text.at( i + 2 ) ) );
+        }
+
+        qSort( result.begin(), result.end() );
+        result.erase( std::unique( result.begin(), result.end() ), result.end() );
+
+        return result;
+    }
+
+    bool ActionIndex::isSubsequence( const QString& needle, const QString& haystack )
+    {
+        int pos = 0;
+
+        for( int i = 0; i < needle.length(); i++ )
+        {
+            pos = haystack.indexOf( needle.at( i ), pos );
+            if( pos == -1 )
+            {
+                return false;
+            }
+            pos++;
+        }
+
+        return true;
+    }
+
+    /**
+     * @internal
+     * @brief       Get the path of menus an action is reachable through
+     *
+     * @param[in]   action  The action to get the path for.
+     *
+     * @return      The titles of the menus, outermost first, separated by " > ". If the action is
+     *              part of more than one menu, the first path that is found is returned.
+     *
+     */
+    QString ActionIndex::menuPath( ActionPrivate* action )
+    {
+        QStringList path;
+        QSet< UiObjectPrivate* > visited;
+
+        UiObjectPrivate* current = action;
+        while( current && !current->mContainers.isEmpty() )
+        {
+            UiContainer* container = *current->mContainers.begin();
+            if( visited.contains( container ) )
+            {
+                break;
+            }
+            visited.insert( container );
+
+            if( container->type() == MenuType )
+            {
+                QString title = static_cast< MenuPrivate* >( container )->mText;
+                title.remove( QLatin1Char( '&' ) );
+
+                if( !title.isEmpty() )
+                {
+                    path.prepend( title );
+                }
+            }
+
+            current = container;
+        }
+
+        return path.join( QLatin1String( " > " ) );
+    }
+
+    void ActionIndex::unindexDocument( ActionPrivate* action ) const
+    {
+        QHash< ActionPrivate*, Document >::iterator it = mDocuments.find( action );
+        if( it == mDocuments.end() )
+        {
+            return;
+        }
+
+        foreach( Trigram trigram, it->mTrigrams )
+        {
+            QHash< Trigram, QSet< ActionPrivate* > >::iterator posting = mPostings.find( trigram );
+            if( posting != mPostings.end() )
+            {
+                posting->remove( action );
+                if( posting->isEmpty() )
+                {
+                    mPostings.erase( posting );
+                }
+            }
+        }
+
+        it->mTrigrams.clear();
+    }
+
+    void ActionIndex::indexDocument( ActionPrivate* action ) const
+    {
+        unindexDocument( action );
+
+        Document& doc = mDocuments[ action ];
+        doc.mTitle = fold( action->mText );
+        doc.mText = doc.mTitle % QLatin1Char( '\n' ) % fold( action->mToolTip ) %
+                    QLatin1Char( '\n' ) % fold( menuPath( action ) );
+        doc.mTrigrams = trigramsOf( doc.mText );
+
+        foreach( Trigram trigram, doc.mTrigrams )
+        {
+            mPostings[ trigram ].insert( action );
+        }
+    }
+
+    void ActionIndex::flush() const
+    {
+        if( mAllDirty )
+        {
+            mAllDirty = false;
+
+            QHash< ActionPrivate*, Document >::const_iterator it = mDocuments.constBegin();
+            for( ; it != mDocuments.constEnd(); ++it )
+            {
+                mDirty.insert( it.key() );
+            }
+        }
+
+        foreach( ActionPrivate* action, mDirty )
+        {
+            indexDocument( action );
+        }
+
+        mDirty.clear();
+    }
+
+    int ActionIndex::score( const Document& doc, const QString& text, int hits ) const
+    {
+        int result = hits * 4;
+
+        int pos = doc.mTitle.indexOf( text );
+        if( pos == 0 )
+        {
+            result += 200;
+        }
+        else if( pos > 0 )
+        {
+            result += 120;
+        }
+        else if( doc.mText.contains( text ) )
+        {
+            result += 80;
+        }
+        else if( isSubsequence( text, doc.mTitle ) )
+        {
+            result += 40;
+        }
+
+        return result;
+    }
+
+    /**
+     * @internal
+     * @brief       Search for actions
+     *
+     * @param[in]   text        The text the user typed.
+     *
+     * @param[in]   maxResults  The maximum number of actions to return.
+     *
+     * @return      Matching actions, best match first. An empty @a text matches all actions, which
+     *              are then ordered by their text. Invisible actions are never returned.
+     *
+     */
+    QList< ActionPrivate* > ActionIndex::query( const QString& text, int maxResults ) const
+    {
+        flush();
+
+        QString q = fold( text );
+        QVector< ActionIndexHit > hits;
+
+        if( q.length() < 3 )
+        {
+            QHash< ActionPrivate*, Document >::const_iterator it = mDocuments.constBegin();
+            for( ; it != mDocuments.constEnd(); ++it )
+            {
+                const Document& doc = it.value();
+                if( !it.key()->mVisible )
+                {
+                    continue;
+                }
+
+                if( q.isEmpty() || doc.mText.contains( q ) || isSubsequence( q, doc.mTitle ) )
+                {
+                    ActionIndexHit hit = { q.isEmpty() ? 0 : score( doc, q, 0 ),
+                                           doc.mTitle, it.key() };
+                    hits.append( hit );
+                }
+            }
+        }
+        else
+        {
+            QVector< Trigram > trigrams = trigramsOf( q );
+            QHash< ActionPrivate*, int > counts;
+
+            foreach( Trigram trigram, trigrams )
+            {
+                QHash< Trigram, QSet< ActionPrivate* > >::const_iterator posting =
+                        mPostings.constFind( trigram );
+
+                if( posting != mPostings.constEnd() )
+                {
+                    foreach( ActionPrivate* action, posting.value() )
+                    {
+                        counts[ action ]++;
+                    }
+                }
+            }
+
+            int threshold = qMax( 1, ( trigrams.count() + 1 ) / 2 );
+
+            QHash< ActionPrivate*, int >::const_iterator it = counts.constBegin();
+            for( ; it != counts.constEnd(); ++it )
+            {
+                if( it.value() >= threshold && it.key()->mVisible )
+                {
+                    const Document& doc = mDocuments[ it.key() ];
+                    ActionIndexHit hit = { score( doc, q, it.value() ), doc.mTitle, it.key() };
+                    hits.append( hit );
+                }
+            }
+        }
+
+        qSort( hits.begin(), hits.end() );
+
+        QList< ActionPrivate* > result;
+        for( int i = 0; i < hits.count() && i < maxResults; i++ )
+        {
+            result.append( hits.at( i ).mAction );
+        }
+
+        return result;
+    }
+
+}
@@ -0,0 +1,78 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MGV_HEAVEN_ACTION_INDEX_H
+#define MGV_HEAVEN_ACTION_INDEX_H
+
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QVector>
+#include <QString>
+
+namespace Heaven
+{
+
+    class UiObjectPrivate;
+    class UiContainer;
+    class ActionPrivate;
+
+    class ActionIndex
+    {
+    public:
+        ActionIndex();
+        ~ActionIndex();
+
+    public:
+        void addAction( ActionPrivate* action );
+        void removeAction( ActionPrivate* action );
+        void invalidate( UiObjectPrivate* uio );
+        void invalidateAll();
+
+        QList< ActionPrivate* > query( const QString& text, int maxResults ) const;
+
+        static QString menuPath( ActionPrivate* action );
+
+    private:
+        typedef quint64 Trigram;
+
+        struct Document
+        {
+            QString             mTitle;
+            QString             mText;
+            QVector< Trigram >  mTrigrams;
+        };
+
+        static QString fold( const QString& text );
+        static QVector< Trigram > trigramsOf( const QString& text );
+        static bool isSubsequence( const QString& needle, const QString& haystack );
+
+        void invalidateBelow( UiObjectPrivate* uio, QSet< UiContainer* >& visited );
+        void flush() const;
+        void indexDocument( ActionPrivate* action ) const;
+        void unindexDocument( ActionPrivate* action ) const;
+        int score( const Document& doc, const QString& text, int hits ) const;
+
+    private:
+        mutable QHash< ActionPrivate*, Document >           mDocuments;
+        mutable QHash< Trigram, QSet< ActionPrivate* > >    mPostings;
+        mutable QSet< ActionPrivate* >                      mDirty;
+        mutable bool                                        mAllDirty;
+    };
+
+}
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QAction>
+#include <QWidget>
+#include <QHash>
+#include <QVector>
+
+#include "libHeavenActions/ActionListBuilder.hpp"
+
+namespace Heaven
+{
+
+    /**
+     * @internal
+     * @class       ActionListBuilder
+     * @brief       Collects the actions a widget should show and applies them as a minimal diff
+     *
+     * The reemerge code of Menu, MenuBar and ToolBar used to clear() the widget and add all
+     * actions again. For a QToolBar this means that every QToolButton is destroyed and recreated
+     * and the bar is layouted once per action.
+     *
+     * An ActionListBuilder is created for one widget. The desired content is fed in via
+     * addAction(), addActions() and addSeparator(). apply() then compares the desired list with
+     * the widget's current actions() and only removes actions that are gone, inserts new ones and
+     * moves actions whose relative position changed. Actions that are part of the longest run
+     * that is already in the right order are left untouched.
+     *
+     * Separators that have been created by a previous builder for the same widget are reused in
+     * order of their appearance, so that they are kept stable as well.
+     *
+     */
+
+    ActionListBuilder::ActionListBuilder( QWidget* widget )
+        : mWidget( widget )
+    {
+        Q_ASSERT( mWidget );
+
+        mCurrent = mWidget->actions();
+
+        foreach( QAction* action, mCurrent )
+        {
+            if( action->isSeparator() && action->parent() == mWidget )
+            {
+                mFreeSeparators.append( action );
+            }
+        }
+    }
+
+    ActionListBuilder::~ActionListBuilder()
+    {
+    }
+
+    QWidget* ActionListBuilder::widget() const
+    {
+        return mWidget;
+    }
+
+    int ActionListBuilder::count() const
+    {
+        return mDesired.count();
+    }
+
+    void ActionListBuilder::addAction( QAction* action )
+    {
+        if( !action || mDesiredSet.contains( action ) )
+        {
+            return;
+        }
+
+        mDesired.append( action );
+        mDesiredSet.insert( action );
+    }
+
+    void ActionListBuilder::addActions( const QList< QAction* >& actions )
+    {
+        foreach( QAction* action, actions )
+        {
+            addAction( action );
+        }
+    }
+
+    void ActionListBuilder::addSeparator()
+    {
+        addAction( takeSeparator() );
+    }
+
+    QAction* ActionListBuilder::takeSeparator()
+    {
+        if( !mFreeSeparators.isEmpty() )
+        {
+            return mFreeSeparators.takeFirst();
+        }
+
+        QAction* separator = new QAction( mWidget );
+        separator->setSeparator( true );
+        return separator;
+    }
+
+    /**
+     * @internal
+     * @brief       Apply the collected actions to the widget
+     *
+     * The builder must not be used any more after calling this method.
+     *
+     */
+    void ActionListBuilder::apply()
+    {
+        // Step 1: Remove everything that is no longer wanted. Separators we created and that were
+        //         not reused are deleted, just as QWidget::clear() would do.
+        QList< QAction* > remaining;
+        remaining.reserve( mCurrent.count() );
+
+        foreach( QAction* action, mCurrent )
+        {
+            if( mDesiredSet.contains( action ) )
+            {
+                remaining.append( action );
+                continue;
+            }
+
+            mWidget->removeAction( action );
+
+            if( mFreeSeparators.contains( action ) )
+            {
+                delete action;
+            }
+        }
+
+        // Step 2: Find the longest subsequence of the desired list that is already in the right
+        //         order inside the widget. Those actions stay where they are.
+        QHash< QAction*, int > currentPos;
+        for( int i = 0; i < remaining.count(); i++ )
+        {
+            currentPos.insert( remaining.at( i ), i );
+        }
+
+        QVector< int > seqPos;      // position inside remaining, for each desired action present
+        QVector< int > seqIndex;    // index into mDesired for the same entry
+        for( int i = 0; i < mDesired.count(); i++ )
+        {
+            QHash< QAction*, int >::const_iterator it = currentPos.constFind( mDesired.at( i ) );
+            if( it != currentPos.constEnd() )
+            {
+                seqPos.append( it.value() );
+                seqIndex.append( i );
+            }
+        }
+
+        QVector< int > tails;                           // index into seq of each run's tail
+        QVector< int > prev( seqPos.count(), -1 );      // predecessor links for reconstruction
+
+        for( int i = 0; i < seqPos.count(); i++ )
+        {
+            int lo = 0, hi = tails.count();
+            while( lo < hi )
+            {
+                int mid = ( lo + hi ) / 2;
+                if( seqPos.at( tails.at( mid ) ) < seqPos.at( i ) )
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+
+            if( lo > 0 )
+            {
+                prev[ i ] = tails.at( lo - 1 );
+            }
+
+            if( lo == tails.count() )
+                tails.append( i );
+            else
+                tails[ lo ] = i;
+        }
+
+        QSet< QAction* > stable;
+        for( int i = tails.isEmpty() ? -1 : tails.last(); i != -1; i = prev.at( i ) )
+        {
+            stable.insert( mDesired.at( seqIndex.at( i ) ) );
+        }
+
+        // Step 3: Walk the desired list backwards and insert / move everything that is not stable
+        //         in front of its successor, which is already in its final place.
+        QAction* before = NULL;
+        for( int i = mDesired.count() - 1; i >= 0; i-- )
+        {
+            QAction* action = mDesired.at( i );
+
+            if( !stable.contains( action ) )
+            {
+                mWidget->insertAction( before, action );
+            }
+
+            before = action;
+        }
+
+        mCurrent.clear();
+        mDesired.clear();
+        mDesiredSet.clear();
+        mFreeSeparators.clear();
+    }
+
+}
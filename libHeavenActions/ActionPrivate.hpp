@@ -17,10 +17,11 @@
 #ifndef MGV_HEAVEN_ACTION_PRIVATE_H
 #define MGV_HEAVEN_ACTION_PRIVATE_H
 
-#include <QSet>
+#include <QHash>
 #include <QIcon>
 #include <QKeySequence>
 #include <QAction>
+#include <QPointer>
 
 #include "libHeavenActions/Action.hpp"
 #include "libHeavenActions/UiObjectPrivate.hpp"
@@ -36,6 +37,28 @@ namespace Heaven
     class ActionPrivate : public UiObjectPrivate
     {
         Q_OBJECT
+    public:
+        enum DirtyProperty
+        {
+            DirtyText               = 1 << 0,
+            DirtyToolTip            = 1 << 1,
+            DirtyStatusTip          = 1 << 2,
+            DirtyEnabled            = 1 << 3,
+            DirtyCheckable          = 1 << 4,
+            DirtyChecked            = 1 << 5,
+            DirtyVisible            = 1 << 6,
+            DirtyIcon               = 1 << 7,
+            DirtyShortcut           = 1 << 8,
+            DirtyShortcutContext    = 1 << 9,
+            DirtyMenuRole           = 1 << 10
+        };
+
+        struct StatePredicate
+        {
+            QPointer< QObject > mReceiver;
+            QByteArray          mMethod;
+        };
+
     public:
         ActionPrivate( Action* owner );
         ~ActionPrivate();
@@ -53,11 +76,21 @@ namespace Heaven
         void setVisible( bool v );
         void setIconRef( const IconRef& ref );
         void setShortcut( const QString &shortcut );
+        void setShortcut( const QKeySequence& shortcut );
         void setShortcutContext( Qt::ShortcutContext context );
         void setMenuRole( QAction::MenuRole role );
 
         void setGroup(ActionGroup* group);
 
+        void flushProperties();
+
+        bool isMaterialized() const;
+        void evaluateState();
+        void trigger();
+
+    public slots:
+        void invalidateState();
+
     private slots:
         void qactionDestroyed();
         void qactionTriggered();
@@ -65,7 +98,11 @@ namespace Heaven
 
     private:
         void createIcon();
-        void updateIcons();
+        void propertiesChanged( int which );
+        void applyProperties( QAction* act, int which );
+        void applyShortcut( QAction* act );
+        QString textFor( QAction* act ) const;
+        bool evaluatePredicate( const StatePredicate& predicate, bool& value );
 
     signals:
         void triggered();
@@ -79,6 +116,7 @@ namespace Heaven
         bool                mEnabled    : 1;
         bool                mCheckable  : 1;
         bool                mChecked    : 1;
+        bool                mStateDirty : 1;
         QString             mText;
         QString             mToolTip;
         QString             mStatusTip;
@@ -87,8 +125,12 @@ namespace Heaven
         QKeySequence        mShortcut;
         Qt::ShortcutContext mShortcutContext;
         QAction::MenuRole   mMenuRole;
-        QSet< QAction* >    mQActions;
+        QHash< QObject*, QAction* > mQActions;
         ActionGroup*        mGroup;
+        int                 mDirtyProperties;
+        StatePredicate      mEnabledPredicate;
+        StatePredicate      mVisiblePredicate;
+        StatePredicate      mCheckedPredicate;
     };
 
 }
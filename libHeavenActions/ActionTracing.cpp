@@ -0,0 +1,266 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QCoreApplication>
+#include <QObject>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QFile>
+
+#include "libHeavenActions/ActionTracingPrivate.hpp"
+
+namespace Heaven
+{
+
+    /**
+     * @class       ActionTracing
+     * @ingroup     Actions
+     * @brief       Records what the action framework spends its time with
+     *
+     * When tracing is enabled, the following is recorded:
+     * - every rebuild of a QMenu, QMenuBar or QToolBar, with the number of items it got,
+     * - every rebuild of a DynamicActionMerger, with the number of actions it produced and
+     * - every trigger of an Action, where the duration is the time spent in the connected slots.
+     *
+     * Tracing is off by default. It can be switched on at runtime with setEnabled() or by setting
+     * the environment variable `HEAVEN_ACTIONS_TRACE` to a non-empty value. When libHeavenActions
+     * is compiled with `HEAVEN_ACTIONS_NO_TRACING` defined, all trace points are compiled out.
+     *
+     * The recorded events can be exported in Chrome's trace event format, which can be loaded into
+     * `chrome://tracing`.
+     *
+     */
+
+    struct TraceEvent
+    {
+        const char* mCategory;
+        const char* mWhat;
+        QString     mSubject;
+        qint64      mStart;
+        qint64      mDuration;
+        int         mCount;
+    };
+
+    static const int sMaxTraceEvents = 250000;
+
+    static bool                     sTracingInitialized = false;
+    static bool                     sTracingEnabled = false;
+    static QElapsedTimer            sTraceClock;
+    static QVector< TraceEvent >*   sTraceEvents = NULL;
+    static int                      sDroppedEvents = 0;
+
+    static qint64 traceNow()
+    {
+        return sTraceClock.nsecsElapsed() / 1000;
+    }
+
+    void ActionTracing::setEnabled( bool enabled )
+    {
+        sTracingInitialized = true;
+        sTracingEnabled = enabled;
+
+        if( enabled && !sTraceClock.isValid() )
+        {
+            sTraceClock.start();
+        }
+    }
+
+    bool ActionTracing::isEnabled()
+    {
+        if( !sTracingInitialized )
+        {
+            setEnabled( !qgetenv( "HEAVEN_ACTIONS_TRACE" ).isEmpty() );
+        }
+
+        return sTracingEnabled;
+    }
+
+    void ActionTracing::clear()
+    {
+        delete sTraceEvents;
+        sTraceEvents = NULL;
+        sDroppedEvents = 0;
+    }
+
+    int ActionTracing::eventCount()
+    {
+        return sTraceEvents ? sTraceEvents->count() : 0;
+    }
+
+    static void appendJsonString( QByteArray& out, const QByteArray& utf8 )
+    {
+        out += '"';
+
+        for( int i = 0; i < utf8.length(); i++ )
+        {
+            char c = utf8.at( i );
+            switch( c )
+            {
+            case '"':   out += "\\\"";  break;
+            case '\\':  out += "\\\\";  break;
+            case '\n':  out += "\\n";   break;
+            case '\r':  out += "\\r";   break;
+            case '\t':  out += "\\t";   break;
+            default:
+                if( uchar( c ) < 0x20 )
+                {
+                    out += "\\u00";
+                    out += QByteArray::number( uchar( c ), 16 ).rightJustified( 2, '0' );
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+        }
+
+        out += '"';
+    }
+
+    /**
+     * @brief       Export all recorded events
+     *
+     * @return      A JSON document in Chrome's trace event format. Each event is a complete
+     *              event (phase `X`) with timestamps in microseconds.
+     *
+     */
+    QByteArray ActionTracing::toChromeTrace()
+    {
+        QByteArray out;
+        QByteArray pid = QByteArray::number( QCoreApplication::applicationPid() );
+
+        out += "{\"traceEvents\":[";
+
+        if( sTraceEvents )
+        {
+            for( int i = 0; i < sTraceEvents->count(); i++ )
+            {
+                const TraceEvent& ev = sTraceEvents->at( i );
+
+                if( i )
+                {
+                    out += ',';
+                }
+
+                out += "\n{\"name\":";
+                appendJsonString( out, QByteArray( ev.mWhat ) + ' ' + ev.mSubject.toUtf8() );
+                out += ",\"cat\":";
+                appendJsonString( out, ev.mCategory );
+                out += ",\"ph\":\"X\",\"ts\":" + QByteArray::number( ev.mStart ) +
+                       ",\"dur\":" + QByteArray::number( ev.mDuration ) +
+                       ",\"pid\":" + pid + ",\"tid\":1";
+
+                if( ev.mCount >= 0 )
+                {
+                    out += ",\"args\":{\"items\":" + QByteArray::number( ev.mCount ) + "}";
+                }
+
+                out += '}';
+            }
+        }
+
+        out += "\n],\"otherData\":{\"droppedEvents\":" + QByteArray::number( sDroppedEvents ) +
+               "}}\n";
+
+        return out;
+    }
+
+    bool ActionTracing::saveChromeTrace( const QString& fileName )
+    {
+        QFile f( fileName );
+        if( !f.open( QFile::WriteOnly | QFile::Truncate ) )
+        {
+            return false;
+        }
+
+        QByteArray data = toChromeTrace();
+        return f.write( data ) == data.length();
+    }
+
+    /**
+     * @internal
+     * @class       TraceScope
+     * @brief       Records one event for the lifetime of the scope
+     *
+     * Use the HEAVEN_TRACE_SCOPE() and HEAVEN_TRACE_COUNT() macros instead of this class, so that
+     * the trace points vanish when `HEAVEN_ACTIONS_NO_TRACING` is defined. If tracing is disabled
+     * at runtime, a TraceScope costs a single flag test.
+     *
+     * @a category and @a what must be string literals. The name of @a subject is taken right away,
+     * since the traced code might delete it (a triggered action may close its view).
+     *
+     */
+    TraceScope::TraceScope( const char* category, const char* what, const QObject* subject )
+        : mActive( ActionTracing::isEnabled() )
+        , mCategory( category )
+        , mWhat( what )
+        , mStart( 0 )
+        , mCount( -1 )
+    {
+        if( !mActive )
+        {
+            return;
+        }
+
+        if( subject )
+        {
+            mSubject = subject->objectName();
+            if( mSubject.isEmpty() )
+            {
+                mSubject = QString::fromLatin1( "%1(0x%2)" )
+                        .arg( QLatin1String( subject->metaObject()->className() ) )
+                        .arg( quintptr( subject ), 0, 16 );
+            }
+        }
+
+        mStart = traceNow();
+    }
+
+    TraceScope::~TraceScope()
+    {
+        if( !mActive )
+        {
+            return;
+        }
+
+        if( !sTraceEvents )
+        {
+            sTraceEvents = new QVector< TraceEvent >;
+        }
+
+        if( sTraceEvents->count() >= sMaxTraceEvents )
+        {
+            sDroppedEvents++;
+            return;
+        }
+
+        TraceEvent ev;
+        ev.mCategory = mCategory;
+        ev.mWhat = mWhat;
+        ev.mStart = mStart;
+        ev.mDuration = traceNow() - mStart;
+        ev.mCount = mCount;
+        ev.mSubject = mSubject;
+
+        sTraceEvents->append( ev );
+    }
+
+    void TraceScope::setCount( int count )
+    {
+        mCount = count;
+    }
+
+}
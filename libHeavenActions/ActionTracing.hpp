@@ -0,0 +1,46 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MGV_HEAVEN_ACTION_TRACING_H
+#define MGV_HEAVEN_ACTION_TRACING_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "libHeavenActions/libHeavenActionsAPI.hpp"
+
+namespace Heaven
+{
+
+    class HEAVEN_ACTIONS_API ActionTracing
+    {
+    public:
+        static void setEnabled( bool enabled );
+        static bool isEnabled();
+
+        static void clear();
+        static int eventCount();
+
+        static QByteArray toChromeTrace();
+        static bool saveChromeTrace( const QString& fileName );
+
+    private:
+        ActionTracing();
+    };
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MGV_HEAVEN_ACTION_TRACING_PRIVATE_H
+#define MGV_HEAVEN_ACTION_TRACING_PRIVATE_H
+
+#include <QString>
+
+class QObject;
+
+#include "libHeavenActions/ActionTracing.hpp"
+
+namespace Heaven
+{
+
+    class TraceScope
+    {
+    public:
+        TraceScope( const char* category, const char* what, const QObject* subject );
+        ~TraceScope();
+
+    public:
+        void setCount( int count );
+
+    private:
+        Q_DISABLE_COPY( TraceScope )
+
+        bool            mActive;
+        const char*     mCategory;
+        const char*     mWhat;
+        QString         mSubject;       // The subject may be gone by the time we record
+        qint64          mStart;
+        int             mCount;
+    };
+
+}
+
+// Define HEAVEN_ACTIONS_NO_TRACING to compile all trace points out of the library.
+#ifndef HEAVEN_ACTIONS_NO_TRACING
+#   define HEAVEN_TRACE_SCOPE( var, category, what, subject ) \
+        Heaven::TraceScope var( category, what, subject )
+#   define HEAVEN_TRACE_COUNT( var, count ) \
+        var.setCount( count )
+#else
+#   define HEAVEN_TRACE_SCOPE( var, category, what, subject ) \
+        do {} while( 0 )
+#   define HEAVEN_TRACE_COUNT( var, count ) \
+        do {} while( 0 )
+#endif
+
+#endif
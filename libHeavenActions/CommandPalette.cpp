@@ -0,0 +1,202 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QCoreApplication>
+#include <QVBoxLayout>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QKeyEvent>
+#include <QStringBuilder>
+
+#include "libHeavenActions/CommandPalette.hpp"
+#include "libHeavenActions/ActionPrivate.hpp"
+#include "libHeavenActions/UiManager.hpp"
+
+namespace Heaven
+{
+
+    /**
+     * @class       CommandPalette
+     * @ingroup     Actions
+     * @brief       A popup to search for and trigger any action by typing a part of its name
+     *
+     * The palette searches the text, the tool tip and the menu path of all Action objects that
+     * exist in the application. Actions that are invisible are not listed; disabled actions are
+     * listed but cannot be triggered.
+     *
+     * Typically, the palette is bound to an application wide shortcut (like Ctrl+Shift+P) and
+     * popup() is called when the shortcut is activated.
+     *
+     */
+
+    CommandPalette::CommandPalette( QWidget* parent )
+        : QFrame( parent, Qt::Popup )
+        , mMaxResults( 50 )
+    {
+        setFrameStyle( QFrame::StyledPanel | QFrame::Raised );
+
+        mFilter = new QLineEdit;
+        mList = new QListWidget;
+        mList->setFocusPolicy( Qt::NoFocus );
+        mList->setUniformItemSizes( true );
+
+        QVBoxLayout* l = new QVBoxLayout;
+        l->setMargin( 2 );
+        l->setSpacing( 2 );
+        l->addWidget( mFilter );
+        l->addWidget( mList );
+        setLayout( l );
+
+        mFilter->installEventFilter( this );
+
+        connect( mFilter, SIGNAL(textChanged(QString)), this, SLOT(filterChanged(QString)) );
+        connect( mList, SIGNAL(itemActivated(QListWidgetItem*)),
+                 this, SLOT(itemActivated(QListWidgetItem*)) );
+    }
+
+    void CommandPalette::setMaxResults( int count )
+    {
+        mMaxResults = qMax( 1, count );
+    }
+
+    int CommandPalette::maxResults() const
+    {
+        return mMaxResults;
+    }
+
+    /**
+     * @brief       Show the palette centered at the top of its parent's window
+     *
+     */
+    void CommandPalette::popup()
+    {
+        mFilter->clear();
+        filterChanged( QString() );
+
+        QWidget* window = parentWidget() ? parentWidget()->window() : NULL;
+        if( window )
+        {
+            int w = qMax( window->width() / 2, 300 );
+            resize( w, qMax( window->height() / 2, 200 ) );
+            move( window->mapToGlobal( QPoint( ( window->width() - w ) / 2, 0 ) ) );
+        }
+
+        show();
+        mFilter->setFocus();
+    }
+
+    void CommandPalette::filterChanged( const QString& text )
+    {
+        QList< ActionPrivate* > found =
+                UiManager::self()->actionIndex()->query( text, mMaxResults );
+
+        mList->clear();
+        mResults.clear();
+
+        foreach( ActionPrivate* action, found )
+        {
+            QString label = action->mText;
+            label.remove( QLatin1Char( '&' ) );
+
+            QString path = ActionIndex::menuPath( action );
+            if( !path.isEmpty() )
+            {
+                label = path % QLatin1String( " > " ) % label;
+            }
+
+            QListWidgetItem* item = new QListWidgetItem( action->mIcon, label );
+            item->setToolTip( action->mToolTip );
+
+            if( !action->mShortcut.isEmpty() )
+            {
+                item->setText( label % QLatin1String( "  (" ) %
+                               action->mShortcut.toString( QKeySequence::NativeText ) %
+                               QLatin1Char( ')' ) );
+            }
+
+            if( !action->mEnabled )
+            {
+                item->setFlags( item->flags() & ~( Qt::ItemIsEnabled | Qt::ItemIsSelectable ) );
+            }
+
+            mList->addItem( item );
+            mResults.append( static_cast< Action* >( action->mOwner ) );
+        }
+
+        for( int i = 0; i < mList->count(); i++ )
+        {
+            if( mList->item( i )->flags() & Qt::ItemIsSelectable )
+            {
+                mList->setCurrentRow( i );
+                break;
+            }
+        }
+    }
+
+    void CommandPalette::itemActivated( QListWidgetItem* item )
+    {
+        int row = mList->row( item );
+        if( row < 0 || row >= mResults.count() || !( item->flags() & Qt::ItemIsEnabled ) )
+        {
+            return;
+        }
+
+        QPointer< Action > action = mResults.at( row );
+        hide();
+
+        if( action )
+        {
+            action->trigger();
+            emit actionTriggered( action );
+        }
+    }
+
+    bool CommandPalette::eventFilter( QObject* watched, QEvent* event )
+    {
+        if( watched == mFilter && event->type() == QEvent::KeyPress )
+        {
+            QKeyEvent* ke = static_cast< QKeyEvent* >( event );
+
+            switch( ke->key() )
+            {
+            case Qt::Key_Up:
+            case Qt::Key_Down:
+            case Qt::Key_PageUp:
+            case Qt::Key_PageDown:
+                QCoreApplication::sendEvent( mList, event );
+                return true;
+
+            case Qt::Key_Return:
+            case Qt::Key_Enter:
+                if( mList->currentItem() )
+                {
+                    itemActivated( mList->currentItem() );
+                }
+                return true;
+
+            case Qt::Key_Escape:
+                hide();
+                return true;
+
+            default:
+                break;
+            }
+        }
+
+        return QFrame::eventFilter( watched, event );
+    }
+
+}
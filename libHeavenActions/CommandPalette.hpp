@@ -0,0 +1,67 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MGV_HEAVEN_COMMAND_PALETTE_H
+#define MGV_HEAVEN_COMMAND_PALETTE_H
+
+#include <QFrame>
+#include <QList>
+#include <QPointer>
+
+class QLineEdit;
+class QListWidget;
+class QListWidgetItem;
+
+#include "libHeavenActions/libHeavenActionsAPI.hpp"
+
+namespace Heaven
+{
+
+    class Action;
+
+    class HEAVEN_ACTIONS_API CommandPalette : public QFrame
+    {
+        Q_OBJECT
+    public:
+        CommandPalette( QWidget* parent = 0 );
+
+    public:
+        void setMaxResults( int count );
+        int maxResults() const;
+
+    public slots:
+        void popup();
+
+    signals:
+        void actionTriggered( Heaven::Action* action );
+
+    protected:
+        bool eventFilter( QObject* watched, QEvent* event );
+
+    private slots:
+        void filterChanged( const QString& text );
+        void itemActivated( QListWidgetItem* item );
+
+    private:
+        QLineEdit*                  mFilter;
+        QListWidget*                mList;
+        QList< QPointer< Action > > mResults;
+        int                         mMaxResults;
+    };
+
+}
+
+#endif
@@ -18,8 +18,15 @@
 
 #include <QAction>
 #include <QWidget>
+#include <QWidgetAction>
+#include <QLineEdit>
+#include <QMenu>
+#include <QStringBuilder>
 
 #include "libHeavenActions/DynamicActionMergerPrivate.hpp"
+#include "libHeavenActions/ActionListBuilder.hpp"
+#include "libHeavenActions/ActionTracingPrivate.hpp"
+#include "libHeavenActions/UiContainer.hpp"
 
 namespace Heaven
 {
@@ -39,6 +46,16 @@ namespace Heaven
      *              key/value pairs into the DAM and this list will be used in the place of the
      *              DynamicActionMerger.
      *
+     * @var         MergerMode::DAMergerPaged
+     *              Like DAMergerCallback, but only one page of entries is generated at a time.
+     *              The merger slot is called with the signature
+     *              `void slot(Heaven::DynamicActionMerger*, int first, int count)` and shall add
+     *              up to @a count entries starting at index @a first. If it adds more than
+     *              pageSize() entries, a "More..." submenu gives access to the next page, which
+     *              is only generated when that submenu is opened. Optionally, a filter field is
+     *              shown above the entries; the slot should then only generate entries that match
+     *              filterText().
+     *
      * @enum        MergerActionLifetime
      * @ingroup     Actions
      * @brief       Lifetime of an action inside a DynamicActionMerger
@@ -67,6 +84,10 @@ namespace Heaven
      *     The advanced mode is more _passive_. The owner installs a list of actions or key/value
      *     pairs into the DAM and this list will be used in the place of the DynamicActionMerger.
      *
+     * -   __Paged__:
+     *     For huge lists (i.e. thousands of tags). Entries are generated page by page through the
+     *     merger slot; see setPageSize() and setFilterEnabled().
+     *
      * The mode can be set with setMode(), the merger slot can be set via setMergerSlot().
      *
      * As with all UiObject classes, a DAM is typically not created directly but rather through the
@@ -83,6 +104,9 @@ namespace Heaven
 
     DynamicActionMergerPrivate::DynamicActionMergerPrivate( DynamicActionMerger* owner )
         : UiObjectPrivate( owner )
+        , mPurgeQueued( false )
+        , mPageSize( 50 )
+        , mFilterEnabled( false )
     {
         mMode = DAMergerCallback;
     }
@@ -90,6 +114,7 @@ namespace Heaven
     DynamicActionMergerPrivate::~DynamicActionMergerPrivate()
     {
         freeActionList();
+        purgePool();
     }
 
     void DynamicActionMergerPrivate::freeActionList()
@@ -107,6 +132,109 @@ namespace Heaven
             }
         }
         mActions.clear();
+        mActionIndex.clear();
+    }
+
+    /**
+     * @internal
+     * @brief       Clear the action list but keep the actions we created for reuse
+     *
+     * Actions that the merger created itself (from a display string or as separator) are moved
+     * to a pool instead of being deleted. As long as the next list contains the same entries,
+     * the very same QActions are used again, so that neither they nor their widgets have to be
+     * recreated. Actions that are not reused are deleted by purgePool().
+     *
+     */
+    void DynamicActionMergerPrivate::recycleActionList()
+    {
+        foreach( ActionListEntry ale, mActions )
+        {
+            if( !ale.mPoolKey.isEmpty() )
+            {
+                mPool.insert( ale.mPoolKey, ale.mAction );
+                continue;
+            }
+
+            if( ale.mAction )
+            {
+                ale.mAction->disconnect( this );
+            }
+
+            if( ale.mLifetime == DAMergerActionMergerControlled )
+            {
+                delete ale.mAction;
+            }
+        }
+        mActions.clear();
+        mActionIndex.clear();
+    }
+
+    void DynamicActionMergerPrivate::appendAction( QAction* act, const QVariant& value,
+                                                   MergerActionLifetime lifeTime,
+                                                   const QString& poolKey )
+    {
+        ActionListEntry le;
+        le.mAction = act;
+        le.mLifetime = lifeTime;
+        le.mValue = value;
+        le.mPoolKey = poolKey;
+
+        if( !act->isSeparator() )
+        {
+            connect( act, SIGNAL(triggered()), this, SLOT(onActionTriggered()),
+                     Qt::UniqueConnection );
+        }
+
+        if( lifeTime == DAMergerActionMergerControlled && act->parent() != mOwner )
+        {
+            act->setParent( mOwner );
+        }
+
+        mActionIndex.insert( act, mActions.count() );
+        mActions.append( le );
+    }
+
+    QAction* DynamicActionMergerPrivate::takePooledAction( const QString& poolKey )
+    {
+        QMultiHash< QString, QAction* >::iterator it = mPool.find( poolKey );
+        if( it == mPool.end() )
+        {
+            return NULL;
+        }
+
+        QAction* act = it.value();
+        mPool.erase( it );
+        return act;
+    }
+
+    void DynamicActionMergerPrivate::queuePoolPurge()
+    {
+        if( !mPurgeQueued && !mPool.isEmpty() )
+        {
+            mPurgeQueued = true;
+            QMetaObject::invokeMethod( this, "purgePool", Qt::QueuedConnection );
+        }
+    }
+
+    void DynamicActionMergerPrivate::purgePool()
+    {
+        mPurgeQueued = false;
+
+        foreach( QAction* act, mPool )
+        {
+            delete act;
+        }
+        mPool.clear();
+    }
+
+    QString DynamicActionMergerPrivate::poolKey( const QString& display, const QVariant& value )
+    {
+        return display % QChar( 0x1F ) % value.toString();
+    }
+
+    QString DynamicActionMergerPrivate::separatorPoolKey()
+    {
+        return QString( QChar( 0x1E ) );
     }
 
     UiObjectTypes DynamicActionMergerPrivate::type() const
@@ -114,29 +242,281 @@ namespace Heaven
         return DynamicActionMergerType;
     }
 
-    void DynamicActionMergerPrivate::addActionsTo( QWidget* widget )
+    void DynamicActionMergerPrivate::addActionsTo( ActionListBuilder& builder )
     {
+        if( mMode == DAMergerPaged )
+        {
+            addPagedActionsTo( builder );
+            return;
+        }
+
         static_cast< DynamicActionMerger* >( mOwner )->triggerRebuild();
 
         foreach( ActionListEntry ale, mActions )
         {
-            widget->addAction( ale.mAction );
+            builder.addAction( ale.mAction );
         }
     }
 
-    void DynamicActionMergerPrivate::onActionTriggered()
+    /**
+     * @internal
+     * @brief       Emerge the first page of a paged merger
+     *
+     * Only the first page is generated here. Further pages are generated when their "More..."
+     * submenu is about to be shown.
+     *
+     */
+    void DynamicActionMergerPrivate::addPagedActionsTo( ActionListBuilder& builder )
+    {
+        recycleActionList();
+
+        // Further pages are regenerated when their menus are shown again.
+        foreach( QMenu* more, mMoreMenus )
+        {
+            more->clear();
+        }
+
+        if( mFilterEnabled )
+        {
+            builder.addAction( filterActionFor( builder.widget() ) );
+        }
+
+        bool hasMore = false;
+        QList< QAction* > page = fetchPage( 0, hasMore );
+        purgePool();
+
+        addPageTo( builder, page, 0, hasMore );
+    }
+
+    void DynamicActionMergerPrivate::addPageTo( ActionListBuilder& builder,
+                                                const QList< QAction* >& page, int first,
+                                                bool hasMore )
+    {
+        foreach( QAction* act, page )
+        {
+            builder.addAction( act );
+        }
+
+        if( hasMore )
+        {
+            builder.addAction( moreMenuFor( builder.widget(), first + mPageSize )->menuAction() );
+        }
+    }
+
+    /**
+     * @internal
+     * @brief       Let the merger slot generate one page of entries
+     *
+     * @param[in]   first   Index of the first entry to generate.
+     *
+     * @param[out]  hasMore Set to `true` if there are entries beyond this page.
+     *
+     * @return      The actions of the page. We ask the merger slot for one entry more than a page
+     *              holds to find out whether there is another page. That entry is dropped again.
+     *
+     */
+    QList< QAction* > DynamicActionMergerPrivate::fetchPage( int first, bool& hasMore )
+    {
+        QList< QAction* > page;
+        int start = mActions.count();
+
+        if( !mMergerSlot.isEmpty() )
+        {
+            QMetaObject::invokeMethod( mOwner->parent(), mMergerSlot.constData(),
+                                       Qt::DirectConnection,
+                                       Q_ARG( Heaven::DynamicActionMerger*,
+                                              static_cast< DynamicActionMerger* >( mOwner ) ),
+                                       Q_ARG( int, first ),
+                                       Q_ARG( int, mPageSize + 1 ) );
+        }
+
+        hasMore = mActions.count() - start > mPageSize;
+        if( hasMore )
+        {
+            dropActionsFrom( start + mPageSize );
+        }
+
+        for( int i = start; i < mActions.count(); i++ )
+        {
+            page.append( mActions.at( i ).mAction );
+        }
+
+        return page;
+    }
+
+    /**
+     * @internal
+     * @brief       Remove the tail of the action list
+     *
+     * @param[in]   index   Index of the first entry to remove.
+     *
+     * Actions we created ourselves go back to the pool, all others are released just like
+     * recycleActionList() would do.
+     *
+     */
+    void DynamicActionMergerPrivate::dropActionsFrom( int index )
+    {
+        for( int i = index; i < mActions.count(); i++ )
+        {
+            const ActionListEntry& ale = mActions.at( i );
+            mActionIndex.remove( ale.mAction );
+
+            if( !ale.mPoolKey.isEmpty() )
+            {
+                mPool.insert( ale.mPoolKey, ale.mAction );
+                continue;
+            }
+
+            if( ale.mAction )
+            {
+                ale.mAction->disconnect( this );
+            }
+
+            if( ale.mLifetime == DAMergerActionMergerControlled )
+            {
+                delete ale.mAction;
+            }
+        }
+
+        mActions.resize( index );
+        queuePoolPurge();
+    }
+
+    /**
+     * @internal
+     * @brief       Make all containers we are emerged into regenerate our pages
+     *
+     */
+    void DynamicActionMergerPrivate::invalidatePages()
+    {
+        foreach( UiContainer* container, mContainers )
+        {
+            container->setContainerDirty();
+        }
+    }
+
+    QWidgetAction* DynamicActionMergerPrivate::filterActionFor( QWidget* widget )
+    {
+        QWidgetAction* wa = mFilterActions.value( widget, NULL );
+        if( wa )
+        {
+            return wa;
+        }
+
+        QLineEdit* edit = new QLineEdit;
+        edit->setText( mFilterText );
+
+        #if QT_VERSION >= 0x040700
+        edit->setPlaceholderText( DynamicActionMerger::trUtf8( "Filter" ) );
+        #endif
+
+        connect( edit, SIGNAL(textChanged(QString)), this, SLOT(onFilterTextChanged(QString)) );
+
+        wa = new QWidgetAction( widget );
+        wa->setDefaultWidget( edit );
+
+        connect( wa, SIGNAL(destroyed()), this, SLOT(onFilterActionDestroyed()) );
+        mFilterActions.insert( widget, wa );
+
+        return wa;
+    }
+
+    QMenu* DynamicActionMergerPrivate::moreMenuFor( QWidget* widget, int first )
+    {
+        QMenu* more = mMoreMenus.value( widget, NULL );
+        if( !more )
+        {
+            more = new QMenu( DynamicActionMerger::trUtf8( "More..." ), widget );
+
+            connect( more, SIGNAL(aboutToShow()), this, SLOT(onMoreMenuAboutToShow()) );
+            connect( more, SIGNAL(destroyed()), this, SLOT(onMoreMenuDestroyed()) );
+            mMoreMenus.insert( widget, more );
+        }
+
+        more->setProperty( "heavenPageFirst", first );
+        return more;
+    }
+
+    void DynamicActionMergerPrivate::onMoreMenuAboutToShow()
+    {
+        QMenu* more = static_cast< QMenu* >( sender() );
+
+        // This menu is emptied whenever the first page is regenerated. As long as it isn't empty,
+        // its content is still current.
+        if( !more->actions().isEmpty() )
+        {
+            return;
+        }
+
+        int first = more->property( "heavenPageFirst" ).toInt();
+
+        bool hasMore = false;
+        QList< QAction* > page = fetchPage( first, hasMore );
+
+        ActionListBuilder builder( more );
+        addPageTo( builder, page, first, hasMore );
+        builder.apply();
+    }
+
+    void DynamicActionMergerPrivate::onFilterTextChanged( const QString& text )
     {
-        foreach( ActionListEntry le, mActions )
+        if( text != mFilterText )
         {
-            if( sender() == le.mAction )
+            mFilterText = text;
+            invalidatePages();
+        }
+    }
+
+    // QObject::destroyed() is emitted from ~QObject(), so the sender must not be cast down. We
+    // only compare the pointers.
+    void DynamicActionMergerPrivate::onFilterActionDestroyed()
+    {
+        QObject* helper = sender();
+
+        QHash< QObject*, QWidgetAction* >::iterator it = mFilterActions.begin();
+        while( it != mFilterActions.end() )
+        {
+            if( static_cast< QObject* >( it.value() ) == helper )
             {
-                DynamicActionMerger* dam = static_cast< DynamicActionMerger* >( mOwner );
-                dam->entryTriggered( le.mValue );
-                return;
+                it = mFilterActions.erase( it );
+            }
+            else
+            {
+                ++it;
             }
         }
     }
 
+    void DynamicActionMergerPrivate::onMoreMenuDestroyed()
+    {
+        QObject* helper = sender();
+
+        QHash< QObject*, QMenu* >::iterator it = mMoreMenus.begin();
+        while( it != mMoreMenus.end() )
+        {
+            if( static_cast< QObject* >( it.value() ) == helper )
+            {
+                it = mMoreMenus.erase( it );
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void DynamicActionMergerPrivate::onActionTriggered()
+    {
+        QAction* act = static_cast< QAction* >( sender() );
+
+        QHash< QAction*, int >::const_iterator it = mActionIndex.constFind( act );
+        if( it != mActionIndex.constEnd() )
+        {
+            DynamicActionMerger* dam = static_cast< DynamicActionMerger* >( mOwner );
+            dam->entryTriggered( mActions.at( it.value() ).mValue );
+        }
+    }
+
     /**
      * @brief       Constructor
      *
@@ -162,16 +542,26 @@ namespace Heaven
     void DynamicActionMerger::triggerRebuild()
     {
         UIOD(DynamicActionMerger);
+        HEAVEN_TRACE_SCOPE( trace, "merger", "DynamicActionMerger", this );
+
+        if( d->mMode == DAMergerPaged )
+        {
+            d->invalidatePages();
+            return;
+        }
 
         if( d->mMode == DAMergerCallback )
         {
-            d->freeActionList();
+            d->recycleActionList();
             if( !d->mMergerSlot.isEmpty() )
             {
                 QMetaObject::invokeMethod( parent(), d->mMergerSlot.constData(),
                                            Qt::DirectConnection,
                                            Q_ARG( Heaven::DynamicActionMerger*, this ) );
             }
+            d->purgePool();
+
+            HEAVEN_TRACE_COUNT( trace, d->mActions.count() );
         }
     }
 
@@ -195,11 +585,15 @@ namespace Heaven
      * For the mode() DAMergerCallback, this happens automatically. For DAMergerAdvancedList the
      * consumer code might want to clear out the list when it shall be regenerated from scratch.
      *
+     * Actions that the merger created itself are kept until the next event loop iteration. If
+     * the same display and value are added again until then, the existing action is reused.
+     *
      */
     void DynamicActionMerger::clear()
     {
         UIOD(DynamicActionMerger);
-        d->freeActionList();
+        d->recycleActionList();
+        d->queuePoolPurge();
     }
 
     /**
@@ -229,24 +623,11 @@ namespace Heaven
 
         if( !act )
         {
-            lifeTime = DAMergerActionMergerControlled;
-            act = new QAction( value.toString(), this );
+            addAction( value.toString(), value );
+            return;
         }
 
-        DynamicActionMergerPrivate::ActionListEntry le;
-        le.mAction = act;
-        le.mLifetime = lifeTime;
-        le.mValue = value;
-
-        connect( act, SIGNAL(triggered()), d, SLOT(onActionTriggered()),
-                 Qt::UniqueConnection );
-
-        if( lifeTime == DAMergerActionMergerControlled && act->parent() != this )
-        {
-            act->setParent( this );
-        }
-
-        d->mActions.append( le );
+        d->appendAction( act, value, lifeTime );
     }
 
     /**
@@ -279,8 +660,17 @@ namespace Heaven
      */
     void DynamicActionMerger::addAction( const QString& display, const QVariant& value )
     {
-        QAction* act = new QAction( display, this );
-        addAction( act, value, DAMergerActionMergerControlled );
+        UIOD(DynamicActionMerger);
+
+        QString key = DynamicActionMergerPrivate::poolKey( display, value );
+        QAction* act = d->takePooledAction( key );
+
+        if( !act )
+        {
+            act = new QAction( display, this );
+        }
+
+        d->appendAction( act, value, DAMergerActionMergerControlled, key );
     }
 
     /**
@@ -293,11 +683,16 @@ namespace Heaven
     {
         UIOD(DynamicActionMerger);
 
-        DynamicActionMergerPrivate::ActionListEntry le;
-        le.mAction = new QAction( this );
-        le.mAction->setSeparator( true );
-        le.mLifetime = DAMergerActionMergerControlled;
-        d->mActions.append( le );
+        QString key = DynamicActionMergerPrivate::separatorPoolKey();
+        QAction* act = d->takePooledAction( key );
+
+        if( !act )
+        {
+            act = new QAction( this );
+            act->setSeparator( true );
+        }
+
+        d->appendAction( act, QVariant(), DAMergerActionMergerControlled, key );
     }
 
     /**
@@ -326,4 +721,79 @@ namespace Heaven
         return d->mMode;
     }
 
+    /**
+     * @brief       Set the number of entries per page
+     *
+     * @param[in]   size    Maximum number of entries shown per page in DAMergerPaged mode.
+     *
+     */
+    void DynamicActionMerger::setPageSize( int size )
+    {
+        UIOD(DynamicActionMerger);
+
+        size = qMax( 1, size );
+        if( size != d->mPageSize )
+        {
+            d->mPageSize = size;
+            d->invalidatePages();
+        }
+    }
+
+    /**
+     * @brief       Get the number of entries per page
+     *
+     * @return      The maximum number of entries shown per page in DAMergerPaged mode. The
+     *              default is 50.
+     *
+     */
+    int DynamicActionMerger::pageSize() const
+    {
+        UIOD(const DynamicActionMerger);
+        return d->mPageSize;
+    }
+
+    /**
+     * @brief       Show a filter field above the entries
+     *
+     * @param[in]   enabled     If `true`, a line edit is shown above the first page in
+     *                          DAMergerPaged mode. Whenever its text changes, the pages are
+     *                          regenerated and the merger slot can consult filterText().
+     *
+     */
+    void DynamicActionMerger::setFilterEnabled( bool enabled )
+    {
+        UIOD(DynamicActionMerger);
+
+        if( enabled != d->mFilterEnabled )
+        {
+            d->mFilterEnabled = enabled;
+            d->invalidatePages();
+        }
+    }
+
+    /**
+     * @brief       Is the filter field enabled?
+     *
+     * @return      `true` if a filter field is shown in DAMergerPaged mode.
+     *
+     */
+    bool DynamicActionMerger::isFilterEnabled() const
+    {
+        UIOD(const DynamicActionMerger);
+        return d->mFilterEnabled;
+    }
+
+    /**
+     * @brief       Get the current filter text
+     *
+     * @return      The text the user entered into the filter field. Merger slots in DAMergerPaged
+     *              mode should only generate matching entries.
+     *
+     */
+    QString DynamicActionMerger::filterText() const
+    {
+        UIOD(const DynamicActionMerger);
+        return d->mFilterText;
+    }
+
 }
@@ -33,7 +33,8 @@ namespace Heaven
     enum MergerMode
     {
         DAMergerCallback,
-        DAMergerAdvancedList
+        DAMergerAdvancedList,
+        DAMergerPaged
     };
 
     enum MergerActionLifetime
@@ -55,6 +56,13 @@ namespace Heaven
         void setMode( MergerMode mode );
         MergerMode mode() const;
 
+        void setPageSize( int size );
+        int pageSize() const;
+
+        void setFilterEnabled( bool enabled );
+        bool isFilterEnabled() const;
+        QString filterText() const;
+
     signals:
         void entryTriggered( const QVariant& value );
 
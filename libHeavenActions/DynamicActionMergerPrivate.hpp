@@ -20,15 +20,22 @@
 #define MGV_HEAVEN_DYNAMIC_ACTION_MERGER_PRIVATE_HPP
 
 #include <QVector>
+#include <QHash>
+#include <QMultiHash>
 
 #include "libHeavenActions/DynamicActionMerger.hpp"
 #include "libHeavenActions/UiObjectPrivate.hpp"
 
 class QAction;
+class QMenu;
+class QWidget;
+class QWidgetAction;
 
 namespace Heaven
 {
 
+    class ActionListBuilder;
+
     class DynamicActionMergerPrivate : public UiObjectPrivate
     {
         Q_OBJECT
@@ -38,6 +45,7 @@ namespace Heaven
             QAction*                mAction;
             MergerActionLifetime    mLifetime;
             QVariant                mValue;
+            QString                 mPoolKey;
         };
 
     public:
@@ -49,18 +57,51 @@ namespace Heaven
 
     public:
         void freeActionList();
-        void addActionsTo( QWidget* widget );
+        void recycleActionList();
+        void addActionsTo( ActionListBuilder& builder );
+        void addPagedActionsTo( ActionListBuilder& builder );
+        void invalidatePages();
+
+        QList< QAction* > fetchPage( int first, bool& hasMore );
+        void dropActionsFrom( int index );
+        void addPageTo( ActionListBuilder& builder, const QList< QAction* >& page, int first,
+                        bool hasMore );
+        QWidgetAction* filterActionFor( QWidget* widget );
+        QMenu* moreMenuFor( QWidget* widget, int first );
+
+        void appendAction( QAction* act, const QVariant& value, MergerActionLifetime lifeTime,
+                           const QString& poolKey = QString() );
+        QAction* takePooledAction( const QString& poolKey );
+        void queuePoolPurge();
+
+        static QString poolKey( const QString& display, const QVariant& value );
+        static QString separatorPoolKey();
+
+    public slots:
+        void purgePool();
 
     private slots:
         void onActionTriggered();
+        void onFilterTextChanged( const QString& text );
+        void onMoreMenuAboutToShow();
+        void onFilterActionDestroyed();
+        void onMoreMenuDestroyed();
 
     private:
         typedef QVector< ActionListEntry > ActionListEntryList;
 
     public:
-        QByteArray          mMergerSlot;
-        ActionListEntryList mActions;
-        MergerMode          mMode;
+        QByteArray                      mMergerSlot;
+        ActionListEntryList             mActions;
+        QHash< QAction*, int >          mActionIndex;
+        QMultiHash< QString, QAction* > mPool;
+        bool                            mPurgeQueued;
+        MergerMode                      mMode;
+        int                             mPageSize;
+        bool                            mFilterEnabled;
+        QString                         mFilterText;
+        QHash< QObject*, QWidgetAction* > mFilterActions;
+        QHash< QObject*, QMenu* >       mMoreMenus;
     };
 
 }
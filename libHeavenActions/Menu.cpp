@@ -15,7 +15,6 @@
  */
 
 #include <QMenu>
-#include <QQueue>
 #include <QAction>
 
 #include "libHeavenActions/MenuPrivate.hpp"
@@ -28,6 +27,8 @@
 #include "libHeavenActions/Separator.hpp"
 #include "libHeavenActions/UiManager.hpp"
 #include "libHeavenActions/MergesManager.hpp"
+#include "libHeavenActions/ActionListBuilder.hpp"
+#include "libHeavenActions/ActionTracingPrivate.hpp"
 
 namespace Heaven
 {
@@ -59,7 +60,10 @@ namespace Heaven
         connect( menu, SIGNAL(destroyed()), this, SLOT(menuDestroyed()) );
         connect( menu, SIGNAL(aboutToShow()), this, SLOT(menuAboutToShow()) );
 
-        mQMenus.insert( menu );
+        mQMenus.insert( forParent, menu );
+
+        // Nothing is in there yet; aboutToShow() or reemergeGuiElement() will fill it
+        mStaleMenus.insert( menu );
 
         #if 0
         qDebug( "MU(%p) - Created QMenu(%p) for QWidget(%p)", owner(), menu, forParent );
@@ -71,12 +75,10 @@ namespace Heaven
 
     QMenu* MenuPrivate::getOrCreateQMenu( QWidget* forParent )
     {
-        foreach( QMenu* menu, mQMenus )
+        QMenu* menu = mQMenus.value( forParent, NULL );
+        if( menu )
         {
-            if( menu->parent() == forParent )
-            {
-                return menu;
-            }
+            return menu;
         }
 
         return createQMenu( forParent );
@@ -90,6 +92,9 @@ namespace Heaven
         {
             menu->setTitle( text );
         }
+
+        // The title is part of the menu path of every action inside this menu.
+        UiManager::self()->actionIndex()->invalidate( this );
     }
 
     void MenuPrivate::setStatusTip( const QString& text )
@@ -124,16 +129,26 @@ namespace Heaven
 
     void MenuPrivate::menuAboutToShow()
     {
-        if( hasDynamicContent() )
+        QMenu* menu = static_cast< QMenu* >( sender() );
+
+        if( mStaleMenus.contains( menu ) || hasDynamicContent() )
         {
-            reemergeGuiElement();
+            populateQMenu( menu );
         }
     }
 
     void MenuPrivate::menuDestroyed()
     {
         QMenu* menu = static_cast< QMenu* >( sender() );
-        if( mQMenus.remove( menu ) )
+
+        QObject* forParent = menu->parent();
+        if( mQMenus.value( forParent ) != menu )
+        {
+            // Someone reparented the QMenu after we created it; search it the hard way.
+            forParent = mQMenus.key( menu, menu );
+        }
+
+        if( mQMenus.remove( forParent ) )
         {
             #if 0
             qDebug( "MU(%p) - QMenu (%p) was removed", owner(), menu );
@@ -147,109 +162,69 @@ namespace Heaven
             #endif
         }
 
+        mStaleMenus.remove( menu );
         UiManager::self()->removeCreatedObject( menu );
     }
 
+    /**
+     * @internal
+     * @brief       Populate stale QMenus that cannot wait for their aboutToShow()
+     *
+     * A QMenu's content is normally built when it is about to be shown for the first time, or
+     * the next time after our content changed. This saves building the QAction trees of menus
+     * that the user never opens.
+     *
+     * Menus that are currently open are populated right away. So are all our QMenus if there is
+     * an Action with a shortcut somewhere below us, as a shortcut only works once its QAction has
+     * been added to a widget.
+     *
+     */
     void MenuPrivate::reemergeGuiElement()
     {
-        MenuPrivate* menuPriv;
-        ActionPrivate* actionPriv;
-        ActionGroupPrivate* actgrpPriv;
-        ActionContainerPrivate* containerPriv;
-        MergePlacePrivate* mergePlacePriv;
-        DynamicActionMergerPrivate* damPriv;
-
         mRebuildQueued = false;
 
-        foreach( QMenu* myMenu, mQMenus )
+        if( mStaleMenus.isEmpty() )
         {
-            #if 0
-            qDebug( "MU(%p) - Reemerge QMenu(%p)", owner(), myMenu );
-            #endif
-            myMenu->clear();
-
-            QQueue< UiObjectPrivate* > todos;
-            foreach (UiObjectPrivate* uio, allObjects()) {
-                todos.enqueue(uio);
-                if (uio->type() == ContainerType) {
-                    UiContainer* cc = static_cast< UiContainer* >(uio);
-                    foreach (UiObjectPrivate* uio2, cc->allObjects()) {
-                        todos.enqueue(uio2);
-                    }
-                }
-            }
+            return;
+        }
+
+        bool eager = containsShortcuts();
 
-            while( !todos.isEmpty() )
+        foreach( QMenu* myMenu, mStaleMenus )
+        {
+            if( eager || myMenu->isVisible() )
             {
-                UiObjectPrivate* uio = todos.dequeue();
-                QList< QAction* > actions;
-
-                // TODO: Do this the other way round. ContainerType will be much easier that way.
-                switch( uio->type() )
-                {
-                case MenuType:
-                    menuPriv = qobject_cast< MenuPrivate* >( uio );
-                    Q_ASSERT( menuPriv );
-                    actions << menuPriv->getOrCreateQMenu( myMenu )->menuAction();
-                    myMenu->addActions( actions );
-                    break;
-
-                case ActionType:
-                    actionPriv = qobject_cast< ActionPrivate* >( uio );
-                    Q_ASSERT( actionPriv );
-                    actions << actionPriv->getOrCreateQAction( myMenu );
-                    myMenu->addActions( actions );
-                    break;
-
-                case ActionGroupType:
-                    actgrpPriv = qobject_cast< ActionGroupPrivate* >(uio);
-                    Q_ASSERT(actgrpPriv);
-                    myMenu->addActions(actgrpPriv->groupForParent(myMenu)->actions());
-                    break;
-
-                case SeparatorType:
-                    myMenu->addSeparator();
-                    break;
-
-                case ContainerType:
-                    containerPriv = qobject_cast< ActionContainerPrivate* >( uio );
-                    Q_ASSERT( containerPriv );
-                    if( containerPriv->isContainerDirty() )
-                    {
-                        // TODO: Force reemerge
-                    }
-                    break;
-
-                case MergePlaceType:
-                    mergePlacePriv = qobject_cast< MergePlacePrivate* >( uio );
-                    Q_ASSERT( mergePlacePriv );
-                    MergesManager::self()->emerge( mergePlacePriv->mName, myMenu );
-                    break;
-
-                case WidgetActionType:
-                    qDebug( "WidgetAction not supported!" );
-                    Q_ASSERT( false );
-                    break;
-
-                case DynamicActionMergerType:
-                    damPriv = qobject_cast< DynamicActionMergerPrivate* >( uio );
-                    Q_ASSERT( damPriv );
-                    damPriv->addActionsTo( myMenu );
-                    break;
-
-                case ToolBarType:
-                case MenuBarType:
-                    // Cannot merge bars into a menu
-                    Q_ASSERT( false );
-                    break;
-                }
+                populateQMenu( myMenu );
             }
         }
     }
 
+    void MenuPrivate::populateQMenu( QMenu* myMenu )
+    {
+        HEAVEN_TRACE_SCOPE( trace, "reemerge", "QMenu", mOwner );
+        mStaleMenus.remove( myMenu );
+
+        #if 0
+        qDebug( "MU(%p) - Reemerge QMenu(%p)", owner(), myMenu );
+        #endif
+        ActionListBuilder builder( myMenu );
+        emergeInto( builder );
+        HEAVEN_TRACE_COUNT( trace, builder.count() );
+        builder.apply();
+    }
+
     void MenuPrivate::setContainerDirty( bool value )
     {
         UiContainer::setContainerDirty( value );
+
+        if( value )
+        {
+            foreach( QMenu* menu, mQMenus )
+            {
+                mStaleMenus.insert( menu );
+            }
+        }
+
         if( value && !mRebuildQueued )
         {
             mRebuildQueued = true;
@@ -26,6 +26,8 @@
 #include "libHeavenActions/Separator.hpp"
 #include "libHeavenActions/UiManager.hpp"
 #include "libHeavenActions/MergesManager.hpp"
+#include "libHeavenActions/ActionListBuilder.hpp"
+#include "libHeavenActions/ActionTracingPrivate.hpp"
 
 namespace Heaven
 {
@@ -53,7 +55,7 @@ namespace Heaven
 
         setContainerDirty();
 
-        mMenuBars.insert( bar );
+        mMenuBars.insert( forParent, bar );
 
         UiManager::self()->addCreatedObject( bar, this );
         return bar;
@@ -65,12 +67,10 @@ namespace Heaven
         forParent = NULL;
         #endif
 
-        foreach( QMenuBar* bar, mMenuBars )
+        QMenuBar* bar = mMenuBars.value( forParent, NULL );
+        if( bar )
         {
-            if( bar->parent() == forParent )
-            {
-                return bar;
-            }
+            return bar;
         }
 
         return createQMenuBar( forParent );
@@ -78,7 +78,16 @@ namespace Heaven
 
     void MenuBarPrivate::qmenubarDestroyed()
     {
-        mMenuBars.remove( static_cast< QMenuBar* >( sender() ) );
+        QMenuBar* bar = static_cast< QMenuBar* >( sender() );
+
+        QObject* forParent = bar->parent();
+        if( mMenuBars.value( forParent ) != bar )
+        {
+            // QMainWindow::setMenuBar() reparents the bar.
+            forParent = mMenuBars.key( bar, bar );
+        }
+
+        mMenuBars.remove( forParent );
 
         UiManager::self()->removeCreatedObject( sender() );
     }
@@ -100,81 +109,16 @@ namespace Heaven
 
     void MenuBarPrivate::reemergeGuiElement()
     {
-        MenuPrivate* menuPriv;
-        ActionPrivate* actionPriv;
-        ActionGroupPrivate* actgrpPriv;
-        ActionContainerPrivate* containerPriv;
-        MergePlacePrivate* mergePlacePriv;
         mRebuildQueued = false;
 
         foreach( QMenuBar* myBar, mMenuBars )
         {
-            // Docs say, clear() isn't sufficient on Mac OS X...
-            // Though, never had a problem with this on Mac OS X.
-            myBar->clear();
-
-            foreach( UiObjectPrivate* uio, allObjects() )
-            {
-                QList< QAction* > actions;
-
-                // TODO: Do this the other way round. ContainerType will be much easier that way.
-                switch( uio->type() )
-                {
-                case MenuType:
-                    menuPriv = qobject_cast< MenuPrivate* >( uio );
-                    Q_ASSERT( menuPriv );
-                    actions << menuPriv->getOrCreateQMenu( myBar )->menuAction();
-                    myBar->addActions( actions );
-                    break;
-
-                case ActionType:
-                    actionPriv = qobject_cast< ActionPrivate* >( uio );
-                    Q_ASSERT( actionPriv );
-                    actions << actionPriv->getOrCreateQAction( myBar );
-                    myBar->addActions( actions );
-                    break;
-
-                case ActionGroupType:
-                    actgrpPriv = qobject_cast< ActionGroupPrivate* >(uio);
-                    Q_ASSERT(actgrpPriv);
-                    myBar->addActions(actgrpPriv->groupForParent(myBar)->actions());
-                    break;
-
-                case SeparatorType:
-                    myBar->addSeparator();
-                    break;
-
-                case ContainerType:
-                    containerPriv = qobject_cast< ActionContainerPrivate* >( uio );
-                    Q_ASSERT( containerPriv );
-                    if( containerPriv->isContainerDirty() )
-                    {
-                        // TODO: Force reemerge
-                    }
-                    break;
-
-                case MergePlaceType:
-                    mergePlacePriv = qobject_cast< MergePlacePrivate* >( uio );
-                    Q_ASSERT( mergePlacePriv );
-                    MergesManager::self()->emerge( mergePlacePriv->mName, myBar );
-                    break;
-
-                case WidgetActionType:
-                    // not implemented
-                    Q_ASSERT( false );
-                    break;
-
-                case DynamicActionMergerType:
-                    Q_ASSERT_X( false, "MenuBar", "Can't merge DAMs directly into bars" );
-                    break;
-
-                case MenuBarType:
-                case ToolBarType:
-                    // cannot merge these into a menubar
-                    Q_ASSERT( false );
-                    break;
-                }
-            }
+            HEAVEN_TRACE_SCOPE( trace, "reemerge", "QMenuBar", mOwner );
+
+            ActionListBuilder builder( myBar );
+            emergeInto( builder );
+            HEAVEN_TRACE_COUNT( trace, builder.count() );
+            builder.apply();
         }
     }
 
@@ -17,7 +17,7 @@
 #ifndef MGV_HEAVEN_MENUBAR_PRIVATE_H
 #define MGV_HEAVEN_MENUBAR_PRIVATE_H
 
-#include <QSet>
+#include <QHash>
 
 class QMenuBar;
 
@@ -48,7 +48,7 @@ namespace Heaven
 
     public:
         bool                mRebuildQueued;
-        QSet< QMenuBar* >   mMenuBars;
+        QHash< QObject*, QMenuBar* > mMenuBars;
     };
 }
 
@@ -17,6 +17,7 @@
 #ifndef MGV_HEAVEN_MENU_PRIVATE_H
 #define MGV_HEAVEN_MENU_PRIVATE_H
 
+#include <QHash>
 #include <QSet>
 
 class QMenu;
@@ -44,6 +45,9 @@ namespace Heaven
         void setStatusTip( const QString& text );
         void setEnabled( bool v );
 
+    private:
+        void populateQMenu( QMenu* myMenu );
+
     private slots:
         void menuAboutToShow();
         void menuDestroyed();
@@ -59,7 +63,8 @@ namespace Heaven
         QString         mText;
         QString         mToolTip;
         QString         mStatusTip;
-        QSet< QMenu* >  mQMenus;
+        QHash< QObject*, QMenu* > mQMenus;
+        QSet< QMenu* >  mStaleMenus;
     };
 
 }
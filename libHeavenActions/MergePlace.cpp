@@ -17,6 +17,7 @@
 #include "libHeavenActions/MergePlacePrivate.hpp"
 #include "libHeavenActions/UiManager.hpp"
 #include "libHeavenActions/MergesManager.hpp"
+#include "libHeavenActions/UiContainer.hpp"
 
 namespace Heaven
 {
@@ -30,7 +31,7 @@ namespace Heaven
     {
         if( !mName.isEmpty() )
         {
-            //MergesManager::self()->removeMergePlace( this );
+            MergesManager::self()->removeMergePlace( this );
         }
     }
 
@@ -47,7 +48,29 @@ namespace Heaven
     void MergePlace::setName( const QByteArray& name )
     {
         UIOD(MergePlace);
+
+        if( name == d->mName )
+        {
+            return;
+        }
+
+        if( !d->mName.isEmpty() )
+        {
+            MergesManager::self()->removeMergePlace( d );
+        }
+
         d->mName = name;
+
+        if( !d->mName.isEmpty() )
+        {
+            MergesManager::self()->createMergePlace( d );
+        }
+
+        // The place now shows different content
+        foreach( UiContainer* holder, d->mContainers )
+        {
+            holder->setContainerDirty();
+        }
     }
 
     QByteArray MergePlace::name() const
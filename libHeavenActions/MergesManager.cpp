@@ -14,8 +14,13 @@
  *
  */
 
+#include <algorithm>
+
+#include <QtAlgorithms>
+
 #include "libHeavenActions/MergesManager.hpp"
 #include "libHeavenActions/MergePlace.hpp"
+#include "libHeavenActions/MergePlacePrivate.hpp"
 
 #include "libHeavenActions/UiContainer.hpp"
 
@@ -23,6 +28,7 @@ namespace Heaven
 {
 
     MergesManager::MergesManager()
+        : mFlushQueued( false )
     {
     }
 
@@ -42,47 +48,176 @@ namespace Heaven
         return sSelf;
     }
 
+    MergesManager::MergePlaces* MergesManager::placesFor( const QByteArray& mergeName )
+    {
+        MergePlaces* place = mKnownPlaces.value( mergeName, NULL );
+        if( !place )
+        {
+            place = new MergePlaces;
+            place->mName = mergeName;
+
+            mKnownPlaces.insert( mergeName, place );
+        }
+
+        return place;
+    }
+
+    /**
+     * @internal
+     * @brief       Schedule a rebuild of everything a merged container is emerged into
+     *
+     * @param[in]   container   The container whose content changed.
+     *
+     * Nothing happens right away. All containers that are marked dirty during one event loop
+     * iteration are handled together in flushDirtyContainers().
+     *
+     */
     void MergesManager::setContainerDirty( UiContainer* container )
     {
+        if( !mMergedInto.contains( container ) )
+        {
+            return;
+        }
+
+        mDirtyContainers.insert( container );
+
+        if( !mFlushQueued )
+        {
+            mFlushQueued = true;
+            QMetaObject::invokeMethod( this, "flushDirtyContainers", Qt::QueuedConnection );
+        }
     }
 
-    void MergesManager::createMergePlace( MergePlace* place )
+    /**
+     * @internal
+     * @brief       Invalidate the flattened content of all holders of places a container is in
+     *
+     * Unlike setContainerDirty(), this happens right away; see UiContainer::invalidateFlattened().
+     *
+     */
+    void MergesManager::invalidateFlattened( UiContainer* container )
     {
-        Q_ASSERT( place );
+        foreach( UiContainer* holder, placeHolders( container ) )
+        {
+            holder->invalidateFlattened();
+        }
+    }
 
-        MergePlaces* mps = mKnownPlaces.value( place->name(), NULL );
+    /**
+     * @internal
+     * @brief       Drop the cached shortcut check of all holders of places a container is in
+     *
+     * See UiContainer::invalidateShortcuts().
+     *
+     */
+    void MergesManager::invalidateShortcuts( UiContainer* container )
+    {
+        foreach( UiContainer* holder, placeHolders( container ) )
+        {
+            holder->invalidateShortcuts();
+        }
+    }
 
-        if( !mps )
+    /**
+     * @internal
+     * @brief       Find the containers holding the MergePlaces a container is merged into
+     *
+     */
+    QList< UiContainer* > MergesManager::placeHolders( UiContainer* container ) const
+    {
+        QList< UiContainer* > holders;
+
+        QHash< UiContainer*, QSet< QByteArray > >::const_iterator it =
+                mMergedInto.constFind( container );
+
+        if( it == mMergedInto.constEnd() )
         {
-            mps = new MergePlaces;
-            mps->mName = place->name();
+            return holders;
+        }
 
-            mKnownPlaces.insert( place->name(), mps );
+        foreach( const QByteArray& name, it.value() )
+        {
+            MergePlaces* place = mKnownPlaces.value( name, NULL );
+            if( !place )
+            {
+                continue;
+            }
+
+            foreach( MergePlacePrivate* mpp, place->mPlaces )
+            {
+                foreach( UiContainer* holder, mpp->mContainers )
+                {
+                    holders.append( holder );
+                }
+            }
         }
 
-        mps->mPlace = place;
+        return holders;
     }
 
-    void MergesManager::removeMergePlace( MergePlace* place )
+    void MergesManager::flushDirtyContainers()
     {
-        if( mKnownPlaces.count() == 0 )
+        QSet< QByteArray > done;
+
+        // Marking a MergePlace's holder dirty might put further merged containers into the dirty
+        // set (i.e. when the holder itself is an ActionContainer that is merged somewhere).
+        while( !mDirtyContainers.isEmpty() )
         {
-            sSelf = NULL;
-            delete this;
+            QSet< QByteArray > names;
+            foreach( UiContainer* container, mDirtyContainers )
+            {
+                names += mMergedInto.value( container );
+            }
+            mDirtyContainers.clear();
+
+            foreach( QByteArray name, names )
+            {
+                if( !done.contains( name ) )
+                {
+                    done.insert( name );
+                    setMergePlaceDirty( name );
+                }
+            }
         }
+
+        mFlushQueued = false;
     }
 
-    bool MergesManager::mergeContainer( UiContainer* container, const QByteArray& mergePlace )
+    void MergesManager::setMergePlaceDirty( const QByteArray& mergeName )
     {
-        MergePlaces* place = mKnownPlaces.value( mergePlace, NULL );
+        MergePlaces* place = mKnownPlaces.value( mergeName, NULL );
         if( !place )
         {
-            place = new MergePlaces;
-            place->mName = mergePlace;
-            place->mPlace = NULL;
+            return;
+        }
 
-            mKnownPlaces.insert( mergePlace, place );
+        foreach( MergePlacePrivate* mpp, place->mPlaces )
+        {
+            foreach( UiContainer* holder, mpp->mContainers )
+            {
+                holder->setContainerDirty();
+            }
         }
+    }
+
+    void MergesManager::createMergePlace( MergePlacePrivate* place )
+    {
+        Q_ASSERT( place );
+        placesFor( place->mName )->mPlaces.insert( place );
+    }
+
+    void MergesManager::removeMergePlace( MergePlacePrivate* place )
+    {
+        MergePlaces* mps = mKnownPlaces.value( place->mName, NULL );
+        if( mps )
+        {
+            mps->mPlaces.remove( place );
+        }
+    }
+
+    bool MergesManager::mergeContainer( UiContainer* container, const QByteArray& mergePlace )
+    {
+        MergePlaces* place = placesFor( mergePlace );
 
         int i = 0, prio = container->priority();
         while( i < place->mContainers.count() && prio > place->mContainers[ i ].mPriority )
@@ -96,74 +231,170 @@ namespace Heaven
         Q_ASSERT( i <= place->mContainers.count() );
 
         place->mContainers.insert( i, ContainerMerge( container, prio ) );
+        mMergedInto[ container ].insert( mergePlace );
 
+        setMergePlaceDirty( mergePlace );
         return true;
     }
 
     void MergesManager::mergeContainer( UiContainer* container, MergePlace* place )
     {
+        Q_ASSERT( place );
+        mergeContainer( container, place->name() );
     }
 
-    void MergesManager::unmergeContainer( UiContainer* container, const QByteArray& mergePlace )
+    bool MergesManager::mergePriorityLessThan( const ContainerMerge& a, const ContainerMerge& b )
     {
+        return a.mPriority < b.mPriority;
     }
 
-    void MergesManager::unmergeContainer( UiContainer* container, MergePlace* place )
+    /**
+     * @internal
+     * @brief       Merge a whole set of containers at once
+     *
+     * @param[in]   merges      The containers and the names of the places to merge them into.
+     *                          Best, these are grouped by merge place and then ordered by
+     *                          priority, as hic generates them. Each group is then merged with the
+     *                          containers already in that place in a single pass.
+     *
+     * The result is the same as calling mergeContainer() for each entry in turn: A container is
+     * put in front of all containers of the same priority that are already in the place, so
+     * containers of the same priority end up in the reverse of the order they are listed in.
+     * Each merge place is rebuilt only once, though.
+     *
+     */
+    void MergesManager::mergeContainers( const QVector< PendingMerge >& merges )
     {
-    }
+        int i = 0;
 
-    void MergesManager::unmergeContainer( UiContainer* container )
-    {
+        while( i < merges.count() )
+        {
+            const QByteArray& name = merges[ i ].mMergePlace;
+            MergePlaces* place = placesFor( name );
+
+            ContainerMergList incoming;
+            bool sorted = true;
+
+            for( ; i < merges.count() && merges[ i ].mMergePlace == name; i++ )
+            {
+                UiContainer* container = merges[ i ].mContainer;
+                ContainerMerge merge( container, container->priority() );
+
+                if( !incoming.isEmpty() && merge.mPriority < incoming.last().mPriority )
+                {
+                    sorted = false;
+                }
+
+                incoming.append( merge );
+                mMergedInto[ container ].insert( name );
+            }
+
+            if( !sorted )
+            {
+                qStableSort( incoming.begin(), incoming.end(), mergePriorityLessThan );
+            }
+
+            // Merged one after the other, each one would go in front of its predecessors
+            for( int g = 0; g < incoming.count(); )
+            {
+                int end = g + 1;
+                while( end < incoming.count() &&
+                       incoming[ end ].mPriority == incoming[ g ].mPriority )
+                {
+                    end++;
+                }
+
+                std::reverse( incoming.begin() + g, incoming.begin() + end );
+                g = end;
+            }
+
+            const ContainerMergList& existing = place->mContainers;
+            ContainerMergList result;
+            result.reserve( existing.count() + incoming.count() );
+
+            int e = 0, n = 0;
+            while( e < existing.count() || n < incoming.count() )
+            {
+                if( n < incoming.count() &&
+                    ( e == existing.count() ||
+                      incoming[ n ].mPriority <= existing[ e ].mPriority ) )
+                {
+                    result.append( incoming[ n++ ] );
+                }
+                else
+                {
+                    result.append( existing[ e++ ] );
+                }
+            }
+
+            place->mContainers = result;
+            setMergePlaceDirty( name );
+        }
     }
 
-    bool MergesManager::emerge( const QByteArray& mergeName, QMenu* menu )
+    void MergesManager::unmergeContainer( UiContainer* container, const QByteArray& mergePlace )
     {
-        MergePlaces* place = mKnownPlaces.value( mergeName, NULL );
+        MergePlaces* place = mKnownPlaces.value( mergePlace, NULL );
         if( !place )
         {
-            return false;
+            return;
         }
 
-        for( int i = 0; i < place->mContainers.count(); i++ )
+        bool found = false;
+        for( int i = place->mContainers.count() - 1; i >= 0; i-- )
         {
-            UiContainer* container = place->mContainers.at( i ).mContainer;
-            container->mergeInto( menu );
+            if( place->mContainers.at( i ).mContainer == container )
+            {
+                place->mContainers.remove( i );
+                found = true;
+            }
         }
 
-        return true;
-    }
-
-    bool MergesManager::emerge( const QByteArray& mergeName, QMenuBar* menuBar )
-    {
-        MergePlaces* place = mKnownPlaces.value( mergeName, NULL );
-        if( !place )
+        QHash< UiContainer*, QSet< QByteArray > >::iterator it = mMergedInto.find( container );
+        if( it != mMergedInto.end() )
         {
-            return false;
+            it.value().remove( mergePlace );
+            if( it.value().isEmpty() )
+            {
+                mMergedInto.erase( it );
+                mDirtyContainers.remove( container );
+            }
         }
 
-        for( int i = 0; i < place->mContainers.count(); i++ )
+        if( found )
         {
-            UiContainer* container = place->mContainers.at( i ).mContainer;
-            container->mergeInto( menuBar );
+            setMergePlaceDirty( mergePlace );
         }
+    }
 
-        return true;
+    void MergesManager::unmergeContainer( UiContainer* container, MergePlace* place )
+    {
+        Q_ASSERT( place );
+        unmergeContainer( container, place->name() );
     }
 
-    bool MergesManager::emerge( const QByteArray& mergeName, QToolBar* toolBar )
+    void MergesManager::unmergeContainer( UiContainer* container )
     {
-        MergePlaces* place = mKnownPlaces.value( mergeName, NULL );
-        if( !place )
+        foreach( QByteArray name, mMergedInto.value( container ) )
         {
-            return false;
+            unmergeContainer( container, name );
         }
+    }
 
-        for( int i = 0; i < place->mContainers.count(); i++ )
+    QList< UiContainer* > MergesManager::mergedContainers( const QByteArray& mergeName ) const
+    {
+        QList< UiContainer* > result;
+
+        MergePlaces* place = mKnownPlaces.value( mergeName, NULL );
+        if( place )
         {
-            UiContainer* container = place->mContainers.at( i ).mContainer;
-            container->mergeInto( toolBar );
+            for( int i = 0; i < place->mContainers.count(); i++ )
+            {
+                result.append( place->mContainers.at( i ).mContainer );
+            }
         }
 
-        return true;
+        return result;
     }
+
 }
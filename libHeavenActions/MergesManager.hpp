@@ -20,10 +20,8 @@
 #include <QObject>
 #include <QVector>
 #include <QHash>
-
-class QMenu;
-class QMenuBar;
-class QToolBar;
+#include <QList>
+#include <QSet>
 
 namespace Heaven
 {
@@ -34,6 +32,7 @@ namespace Heaven
 
     class MergesManager : public QObject
     {
+        Q_OBJECT
     private:
         MergesManager();
         ~MergesManager();
@@ -43,20 +42,34 @@ namespace Heaven
 
     public:
         void setContainerDirty( UiContainer* container );
+        void invalidateFlattened( UiContainer* container );
+        void invalidateShortcuts( UiContainer* container );
+
+        void createMergePlace( MergePlacePrivate* place );
+        void removeMergePlace( MergePlacePrivate* place );
 
-        void createMergePlace( MergePlace* place );
-        void removeMergePlace( MergePlace* place );
+        struct PendingMerge
+        {
+            UiContainer*    mContainer;
+            QByteArray      mMergePlace;
+        };
 
         bool mergeContainer( UiContainer* container, const QByteArray& mergePlace );
         void mergeContainer( UiContainer* container, MergePlace* place );
+        void mergeContainers( const QVector< PendingMerge >& merges );
 
         void unmergeContainer( UiContainer* container, const QByteArray& mergePlace );
         void unmergeContainer( UiContainer* container, MergePlace* place );
         void unmergeContainer( UiContainer* container );
 
-        bool emerge( const QByteArray& mergeName, QMenu* menu );
-        bool emerge( const QByteArray& mergeName, QMenuBar* menuBar );
-        bool emerge( const QByteArray& mergeName, QToolBar* toolBar );
+        QList< UiContainer* > mergedContainers( const QByteArray& mergeName ) const;
+
+    private:
+        void setMergePlaceDirty( const QByteArray& mergeName );
+        QList< UiContainer* > placeHolders( UiContainer* container ) const;
+
+    private slots:
+        void flushDirtyContainers();
 
     private:
         static MergesManager* sSelf;
@@ -81,14 +94,21 @@ namespace Heaven
 
         typedef QVector< ContainerMerge > ContainerMergList;
 
+        static bool mergePriorityLessThan( const ContainerMerge& a, const ContainerMerge& b );
+
         struct MergePlaces
         {
-            QByteArray          mName;
-            MergePlace*         mPlace;
-            ContainerMergList   mContainers;
+            QByteArray                  mName;
+            QSet< MergePlacePrivate* >  mPlaces;
+            ContainerMergList           mContainers;
         };
 
-        QHash< QByteArray, MergePlaces* > mKnownPlaces;
+        MergePlaces* placesFor( const QByteArray& mergeName );
+
+        QHash< QByteArray, MergePlaces* >           mKnownPlaces;
+        QHash< UiContainer*, QSet< QByteArray > >   mMergedInto;
+        QSet< UiContainer* >                        mDirtyContainers;
+        bool                                        mFlushQueued;
     };
 
 }
@@ -26,6 +26,8 @@
 #include "libHeavenActions/Separator.hpp"
 #include "libHeavenActions/UiManager.hpp"
 #include "libHeavenActions/MergesManager.hpp"
+#include "libHeavenActions/ActionListBuilder.hpp"
+#include "libHeavenActions/ActionTracingPrivate.hpp"
 
 namespace Heaven
 {
@@ -48,7 +50,7 @@ namespace Heaven
 
         setContainerDirty();
 
-        mToolBars.insert( bar );
+        mToolBars.insert( forParent, bar );
 
         #if 0
         qDebug( "TB(%p) - Created QToolBar(%p) for QWidget(%p)", owner(), bar, forParent );
@@ -60,12 +62,10 @@ namespace Heaven
 
     QToolBar* ToolBarPrivate::getOrCreateQToolBar( QWidget* forParent )
     {
-        foreach( QToolBar* bar, mToolBars )
+        QToolBar* bar = mToolBars.value( forParent, NULL );
+        if( bar )
         {
-            if( bar->parent() == forParent )
-            {
-                return bar;
-            }
+            return bar;
         }
 
         return createQToolBar( forParent );
@@ -74,7 +74,15 @@ namespace Heaven
     void ToolBarPrivate::qtoolbarDestroyed()
     {
         QToolBar* t = static_cast< QToolBar* >( sender() );
-        if( mToolBars.remove( t ) )
+
+        QObject* forParent = t->parent();
+        if( mToolBars.value( forParent ) != t )
+        {
+            // QToolBars get reparented when they are added to a QMainWindow.
+            forParent = mToolBars.key( t, t );
+        }
+
+        if( mToolBars.remove( forParent ) )
         {
             #if 0
             qDebug( "TB(%p) - QToolBar (%p) was removed", owner(), t );
@@ -108,79 +116,16 @@ namespace Heaven
 
     void ToolBarPrivate::reemergeGuiElement()
     {
-        MenuPrivate* menuPriv;
-        ActionPrivate* actionPriv;
-        ActionGroupPrivate* actgrpPriv;
-        ActionContainerPrivate* containerPriv;
-        MergePlacePrivate* mergePlacePriv;
         mRebuildQueued = false;
 
         foreach( QToolBar* myBar, mToolBars )
         {
-            myBar->clear();
-
-            foreach( UiObjectPrivate* uio, allObjects() )
-            {
-                QList< QAction* > actions;
-
-                // TODO: Do this the other way round. ContainerType will be much easier that way.
-                switch( uio->type() )
-                {
-                case MenuType:
-                    menuPriv = qobject_cast< MenuPrivate* >( uio );
-                    Q_ASSERT( menuPriv );
-                    actions << menuPriv->getOrCreateQMenu( myBar )->menuAction();
-                    myBar->addActions( actions );
-                    break;
-
-                case ActionType:
-                    actionPriv = qobject_cast< ActionPrivate* >( uio );
-                    Q_ASSERT( actionPriv );
-                    actions << actionPriv->getOrCreateQAction( myBar );
-                    myBar->addActions( actions );
-                    break;
-
-                case ActionGroupType:
-                    actgrpPriv = qobject_cast< ActionGroupPrivate* >(uio);
-                    Q_ASSERT(actgrpPriv);
-                    myBar->addActions(actgrpPriv->groupForParent(myBar)->actions());
-                    break;
-
-                case SeparatorType:
-                    myBar->addSeparator();
-                    break;
-
-                case ContainerType:
-                    containerPriv = qobject_cast< ActionContainerPrivate* >( uio );
-                    Q_ASSERT( containerPriv );
-                    if( containerPriv->isContainerDirty() )
-                    {
-                        // TODO: Force reemerge
-                    }
-                    break;
-
-                case MergePlaceType:
-                    mergePlacePriv = qobject_cast< MergePlacePrivate* >( uio );
-                    Q_ASSERT( mergePlacePriv );
-                    MergesManager::self()->emerge( mergePlacePriv->mName, myBar );
-                    break;
-
-                case MenuBarType:
-                case ToolBarType:
-                    // Cannot merge Bars into Toolbars
-                    Q_ASSERT( false );
-                    break;
-
-                case DynamicActionMergerType:
-                    Q_ASSERT_X( false, "ToolBar", "Can't merge DAMs directly into bars" );
-                    break;
-
-                case WidgetActionType:
-                    qDebug( "WidgetAction not supported!" );
-                    Q_ASSERT( false );
-                    break;
-                }
-            }
+            HEAVEN_TRACE_SCOPE( trace, "reemerge", "QToolBar", mOwner );
+
+            ActionListBuilder builder( myBar );
+            emergeInto( builder );
+            HEAVEN_TRACE_COUNT( trace, builder.count() );
+            builder.apply();
         }
     }
 
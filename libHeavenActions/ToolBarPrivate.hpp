@@ -17,6 +17,8 @@
 #ifndef MGV_HEAVEN_TOOL_PRIVATE_H
 #define MGV_HEAVEN_TOOL_PRIVATE_H
 
+#include <QHash>
+
 #include "libHeavenActions/ToolBar.hpp"
 #include "libHeavenActions/UiContainer.hpp"
 
@@ -44,7 +46,7 @@ namespace Heaven
 
     public:
         bool                mRebuildQueued;
-        QSet< QToolBar* >   mToolBars;
+        QHash< QObject*, QToolBar* > mToolBars;
     };
 
 }
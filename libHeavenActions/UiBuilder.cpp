@@ -0,0 +1,444 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QCoreApplication>
+
+#include "libHeavenActions/UiBuilder.hpp"
+#include "libHeavenActions/Action.hpp"
+#include "libHeavenActions/ActionGroup.hpp"
+#include "libHeavenActions/WidgetAction.hpp"
+#include "libHeavenActions/Menu.hpp"
+#include "libHeavenActions/MenuBar.hpp"
+#include "libHeavenActions/ToolBar.hpp"
+#include "libHeavenActions/MergePlace.hpp"
+#include "libHeavenActions/ActionContainer.hpp"
+#include "libHeavenActions/DynamicActionMerger.hpp"
+#include "libHeavenActions/ActionContainerPrivate.hpp"
+#include "libHeavenActions/MergesManager.hpp"
+
+namespace Heaven
+{
+
+    /**
+     * @class       UiBuilder
+     * @brief       Instantiates a Ui from the descriptor tables hic generates
+     *
+     * When hic is run with `--tables`, it doesn't generate a setupActions() method that creates
+     * and configures every object with its own sequence of calls. Instead it emits static tables
+     * describing the objects, their properties and the content of the containers and a short
+     * setupActions() method that hands these tables to build().
+     *
+     * The tables are plain data, so they end up in read only memory and the code to walk them
+     * exists only once in this library, no matter how many Uis an application has.
+     *
+     * Containers that are merged into merge places are collected while building and handed to
+     * the MergesManager at once, so that each merge place is rebuilt only once. The imperative
+     * and lazy modes of hic use merge() for the same purpose.
+     *
+     */
+
+    static const char* const sNamePrefixes[] =
+    {
+        "act", "agrp", "wac", "mp", "menu", "mb", "tb", "ac", "dam"
+    };
+
+    static QString stringValue( const UiDescriptor& descriptor, const UiPropertyDescriptor& prop )
+    {
+        if( !prop.mTranslate )
+        {
+            return QLatin1String( prop.mString );
+        }
+
+        return QCoreApplication::translate( descriptor.mTrContext, prop.mString, NULL
+                                    #if QT_VERSION < 0x050000
+                                            , QCoreApplication::UnicodeUTF8
+                                    #endif
+                                            );
+    }
+
+    static QByteArray methodSignature( int code, const char* signature )
+    {
+        return QByteArray::number( code ) + signature;
+    }
+
+    static UiObject* createObject( const UiObjectDescriptor& desc, QObject* parent )
+    {
+        switch( desc.mKind )
+        {
+        case UiDescAction:
+            return new Action( parent );
+
+        case UiDescActionGroup:
+            return new ActionGroup( parent );
+
+        case UiDescWidgetAction:
+            return new WidgetAction( parent );
+
+        case UiDescMergePlace:
+            {
+                MergePlace* mp = new MergePlace( parent );
+                mp->setName( QByteArray( desc.mName ) );
+                return mp;
+            }
+
+        case UiDescMenu:
+            return new Menu( parent );
+
+        case UiDescMenuBar:
+            return new MenuBar( parent );
+
+        case UiDescToolBar:
+            return new ToolBar( parent );
+
+        case UiDescContainer:
+            return new ActionContainer( parent );
+
+        case UiDescDynamicActionMerger:
+            return new DynamicActionMerger( parent );
+
+        default:
+            qWarning( "UiBuilder: Unknown object kind %i", int( desc.mKind ) );
+            return NULL;
+        }
+    }
+
+    static void setActionProperty( const UiDescriptor& descriptor, const UiPropertyDescriptor& prop,
+                                   Action* action, QObject* parent )
+    {
+        switch( prop.mProperty )
+        {
+        case UiPropText:
+            action->setText( stringValue( descriptor, prop ) );
+            break;
+
+        case UiPropStatusToolTip:
+            action->setStatusToolTip( stringValue( descriptor, prop ) );
+            break;
+
+        case UiPropMenuRole:
+            action->setMenuRole( QAction::MenuRole( prop.mValue ) );
+            break;
+
+        case UiPropCheckable:
+            action->setCheckable( prop.mValue != 0 );
+            break;
+
+        case UiPropChecked:
+            action->setChecked( prop.mValue != 0 );
+            break;
+
+        case UiPropVisible:
+            action->setVisible( prop.mValue != 0 );
+            break;
+
+        case UiPropEnabled:
+            action->setEnabled( prop.mValue != 0 );
+            break;
+
+        case UiPropIconRef:
+            action->setIconRef( stringValue( descriptor, prop ) );
+            break;
+
+        case UiPropShortcut:
+            if( prop.mString )
+            {
+                action->setShortcut( stringValue( descriptor, prop ) );
+            }
+            else
+            {
+                // hic already parsed it into a single chord
+                action->setShortcut( QKeySequence( prop.mValue ) );
+            }
+            break;
+
+        case UiPropShortcutContext:
+            action->setShortcutContext( Qt::ShortcutContext( prop.mValue ) );
+            break;
+
+        case UiPropConnectTo:
+            QObject::connect( action,
+                              prop.mValue ? SIGNAL(toggled(bool)) : SIGNAL(triggered()),
+                              parent,
+                              methodSignature( QSLOT_CODE, prop.mString ).constData() );
+            break;
+
+        default:
+            qWarning( "UiBuilder: Property %i is not supported by actions", int( prop.mProperty ) );
+            break;
+        }
+    }
+
+    static void setMenuProperty( const UiDescriptor& descriptor, const UiPropertyDescriptor& prop,
+                                 Menu* menu )
+    {
+        switch( prop.mProperty )
+        {
+        case UiPropText:
+            menu->setText( stringValue( descriptor, prop ) );
+            break;
+
+        case UiPropStatusToolTip:
+            menu->setStatusToolTip( stringValue( descriptor, prop ) );
+            break;
+
+        default:
+            qWarning( "UiBuilder: Property %i is not supported by menus", int( prop.mProperty ) );
+            break;
+        }
+    }
+
+    static void setMergerProperty( const UiPropertyDescriptor& prop, DynamicActionMerger* dam,
+                                   QObject* parent )
+    {
+        switch( prop.mProperty )
+        {
+        case UiPropMergerSlot:
+            dam->setMergerSlot( prop.mString );
+            break;
+
+        case UiPropRebuildSignal:
+            QObject::connect( parent, methodSignature( QSIGNAL_CODE, prop.mString ).constData(),
+                              dam, SLOT(triggerRebuild()) );
+            break;
+
+        default:
+            qWarning( "UiBuilder: Property %i is not supported by mergers", int( prop.mProperty ) );
+            break;
+        }
+    }
+
+    static void setContainerProperty( const UiPropertyDescriptor& prop, ActionContainer* container )
+    {
+        switch( prop.mProperty )
+        {
+        case UiPropMergePriority:
+            container->setMergePriority( prop.mValue );
+            break;
+
+        case UiPropMergeInto:
+            // Merged in one go by build(), once all containers are filled
+            break;
+
+        default:
+            qWarning( "UiBuilder: Property %i is not supported by containers",
+                      int( prop.mProperty ) );
+            break;
+        }
+    }
+
+    template< class T >
+    static void addTo( UiObject* container, UiObject* child )
+    {
+        T* c = static_cast< T* >( container );
+
+        if( child )
+        {
+            c->add( child );
+        }
+        else
+        {
+            c->addSeparator();
+        }
+    }
+
+    static void addContent( const UiObjectDescriptor& desc, UiObject* container, UiObject* child )
+    {
+        switch( desc.mKind )
+        {
+        case UiDescActionGroup:
+            if( child && qobject_cast< Action* >( child ) )
+            {
+                static_cast< ActionGroup* >( container )->add( static_cast< Action* >( child ) );
+            }
+            break;
+
+        case UiDescMenu:
+            addTo< Menu >( container, child );
+            break;
+
+        case UiDescMenuBar:
+            addTo< MenuBar >( container, child );
+            break;
+
+        case UiDescToolBar:
+            addTo< ToolBar >( container, child );
+            break;
+
+        case UiDescContainer:
+            addTo< ActionContainer >( container, child );
+            break;
+
+        default:
+            qWarning( "UiBuilder: Object kind %i cannot have content", int( desc.mKind ) );
+            break;
+        }
+    }
+
+    /**
+     * @brief       Instantiate a Ui from its descriptor
+     *
+     * @param[in]   descriptor  The tables describing the Ui, as generated by hic.
+     *
+     * @param[in]   parent      The QObject to parent all created objects to. This is also the
+     *                          object that actions connect to and whose signals trigger merger
+     *                          rebuilds.
+     *
+     * @param[out]  objects     An array with room for `descriptor.mObjectCount` pointers. On
+     *                          return, it contains the created objects in the order of the object
+     *                          table.
+     *
+     * Objects are created first, then their properties are applied and finally the containers are
+     * filled; this is the same order the imperative setupActions() uses.
+     *
+     */
+    void UiBuilder::build( const UiDescriptor& descriptor, QObject* parent, UiObject** objects )
+    {
+        for( int i = 0; i < descriptor.mObjectCount; i++ )
+        {
+            const UiObjectDescriptor& desc = descriptor.mObjects[ i ];
+            UiObject* obj = createObject( desc, parent );
+            objects[ i ] = obj;
+
+            if( obj )
+            {
+                obj->setObjectName( QLatin1String( sNamePrefixes[ desc.mKind ] ) +
+                                    QString::fromUtf8( desc.mName ) );
+            }
+        }
+
+        for( int i = 0; i < descriptor.mPropertyCount; i++ )
+        {
+            const UiPropertyDescriptor& prop = descriptor.mProperties[ i ];
+            UiObject* obj = objects[ prop.mObject ];
+            if( !obj )
+            {
+                continue;
+            }
+
+            switch( descriptor.mObjects[ prop.mObject ].mKind )
+            {
+            case UiDescAction:
+                setActionProperty( descriptor, prop, static_cast< Action* >( obj ), parent );
+                break;
+
+            case UiDescMenu:
+                setMenuProperty( descriptor, prop, static_cast< Menu* >( obj ) );
+                break;
+
+            case UiDescDynamicActionMerger:
+                setMergerProperty( prop, static_cast< DynamicActionMerger* >( obj ), parent );
+                break;
+
+            case UiDescContainer:
+                setContainerProperty( prop, static_cast< ActionContainer* >( obj ) );
+                break;
+
+            default:
+                qWarning( "UiBuilder: Object kind %i has no properties",
+                          int( descriptor.mObjects[ prop.mObject ].mKind ) );
+                break;
+            }
+        }
+
+        for( int i = 0; i < descriptor.mContentCount; i++ )
+        {
+            const UiContentDescriptor& content = descriptor.mContent[ i ];
+            UiObject* container = objects[ content.mContainer ];
+            UiObject* child = NULL;
+
+            if( content.mChild != UiContentSeparator )
+            {
+                child = objects[ content.mChild ];
+                if( !child )
+                {
+                    continue;
+                }
+            }
+
+            if( container )
+            {
+                addContent( descriptor.mObjects[ content.mContainer ], container, child );
+            }
+        }
+
+        QVector< MergesManager::PendingMerge > merges;
+
+        for( int i = 0; i < descriptor.mPropertyCount; i++ )
+        {
+            const UiPropertyDescriptor& prop = descriptor.mProperties[ i ];
+            UiObject* obj = objects[ prop.mObject ];
+
+            if( prop.mProperty == UiPropMergeInto && obj &&
+                descriptor.mObjects[ prop.mObject ].mKind == UiDescContainer )
+            {
+                MergesManager::PendingMerge merge;
+                merge.mContainer = containerOf( obj );
+                merge.mMergePlace = QByteArray( prop.mString );
+                merges.append( merge );
+            }
+        }
+
+        if( !merges.isEmpty() )
+        {
+            MergesManager::self()->mergeContainers( merges );
+        }
+    }
+
+    UiContainer* UiBuilder::containerOf( UiObject* container )
+    {
+        return static_cast< ActionContainerPrivate* >(
+                    static_cast< ActionContainer* >( container )->mPrivate );
+    }
+
+    /**
+     * @brief       Merge containers into their merge places in one go
+     *
+     * @param[in]   routes      The routes, as generated by hic. They should be ordered by merge
+     *                          place and then by the priority of their containers.
+     *
+     * @param[in]   count       The number of routes.
+     *
+     * @param[in]   containers  The ActionContainers the routes refer to by index.
+     *
+     * The result is the same as calling ActionContainer::mergeInto() for each route in turn (see
+     * MergesManager::mergeContainers() for the order this gives), except that each merge place
+     * is filled and rebuilt only once.
+     *
+     */
+    void UiBuilder::merge( const UiMergeRoute* routes, int count, UiObject* const* containers )
+    {
+        QVector< MergesManager::PendingMerge > merges;
+        merges.reserve( count );
+
+        for( int i = 0; i < count; i++ )
+        {
+            UiObject* obj = containers[ routes[ i ].mContainer ];
+            if( !qobject_cast< ActionContainer* >( obj ) )
+            {
+                qWarning( "UiBuilder: Only ActionContainers can be merged" );
+                continue;
+            }
+
+            MergesManager::PendingMerge merge;
+            merge.mContainer = containerOf( obj );
+            merge.mMergePlace = QByteArray( routes[ i ].mMergePlace );
+            merges.append( merge );
+        }
+
+        MergesManager::self()->mergeContainers( merges );
+    }
+
+}
@@ -0,0 +1,124 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MGV_HEAVEN_UI_BUILDER_H
+#define MGV_HEAVEN_UI_BUILDER_H
+
+#include "libHeavenActions/libHeavenActionsAPI.hpp"
+
+class QObject;
+
+namespace Heaven
+{
+
+    class UiObject;
+    class UiContainer;
+
+    enum UiDescriptorKind
+    {
+        UiDescAction,
+        UiDescActionGroup,
+        UiDescWidgetAction,
+        UiDescMergePlace,
+        UiDescMenu,
+        UiDescMenuBar,
+        UiDescToolBar,
+        UiDescContainer,
+        UiDescDynamicActionMerger
+    };
+
+    enum UiDescriptorProperty
+    {
+        UiPropText,
+        UiPropStatusToolTip,
+        UiPropMenuRole,
+        UiPropCheckable,
+        UiPropChecked,
+        UiPropVisible,
+        UiPropEnabled,
+        UiPropIconRef,
+        UiPropShortcut,             //!< mString is NULL if mValue holds the parsed key sequence
+        UiPropShortcutContext,
+        UiPropConnectTo,            //!< mString is a slot of the parent, mValue = 1 for toggled()
+        UiPropMergerSlot,
+        UiPropRebuildSignal,        //!< mString is a signal of the parent
+        UiPropMergePriority,
+        UiPropMergeInto             //!< mString is a merge place; see UiMergeRoute for the order
+    };
+
+    enum
+    {
+        UiContentSeparator = 0xFFFF
+    };
+
+    struct UiObjectDescriptor
+    {
+        unsigned short              mKind;
+        const char*                 mName;
+    };
+
+    struct UiPropertyDescriptor
+    {
+        unsigned short              mObject;
+        unsigned char               mProperty;
+        unsigned char               mTranslate;
+        const char*                 mString;
+        int                         mValue;
+    };
+
+    struct UiContentDescriptor
+    {
+        unsigned short              mContainer;
+        unsigned short              mChild;
+    };
+
+    /**
+     * @brief       Merges an ActionContainer into a merge place
+     *
+     * hic writes routes ordered by merge place and then by the priority of the containers, so
+     * that each merge place is filled in a single pass.
+     */
+    struct UiMergeRoute
+    {
+        unsigned short              mContainer;
+        const char*                 mMergePlace;
+    };
+
+    struct UiDescriptor
+    {
+        const char*                 mTrContext;
+        const UiObjectDescriptor*   mObjects;
+        int                         mObjectCount;
+        const UiPropertyDescriptor* mProperties;
+        int                         mPropertyCount;
+        const UiContentDescriptor*  mContent;
+        int                         mContentCount;
+    };
+
+    class HEAVEN_ACTIONS_API UiBuilder
+    {
+    public:
+        static void build( const UiDescriptor& descriptor, QObject* parent, UiObject** objects );
+        static void merge( const UiMergeRoute* routes, int count, UiObject* const* containers );
+
+    private:
+        UiBuilder();
+        static UiContainer* containerOf( UiObject* container );
+    };
+
+}
+
+#endif
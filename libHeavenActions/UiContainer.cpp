@@ -15,10 +15,9 @@
  */
 
 #include <QMenu>
-#include <QMenuBar>
-#include <QToolBar>
 
 #include "libHeavenActions/UiContainer.hpp"
+#include "libHeavenActions/ActionListBuilder.hpp"
 #include "libHeavenActions/UiManager.hpp"
 #include "libHeavenActions/ActionContainerPrivate.hpp"
 #include "libHeavenActions/MenuPrivate.hpp"
@@ -30,6 +29,7 @@
 #include "libHeavenActions/MergesManager.hpp"
 #include "libHeavenActions/WidgetActionWrapper.hpp"
 #include "libHeavenActions/DynamicActionMergerPrivate.hpp"
+#include "libHeavenActions/ActionTracingPrivate.hpp"
 
 namespace Heaven
 {
@@ -37,11 +37,26 @@ namespace Heaven
     UiContainer::UiContainer( QObject* owner )
         : UiObjectPrivate( owner )
         , mDirty( false )
+        , mPropagatingDirty( false )
+        , mFlattenedValid( false )
+        , mInvalidatingFlattened( false )
+        , mContentProvider( NULL )
+        , mContentContext( NULL )
+        , mDeferredShortcuts( false )
+        , mShortcutsValid( false )
+        , mHasShortcuts( false )
+        , mInvalidatingShortcuts( false )
     {
     }
 
     UiContainer::~UiContainer()
     {
+        foreach( UiObjectPrivate* uio, mContent )
+        {
+            uio->removedFromContainer( this );
+        }
+
+        UiManager::self()->invalidateActivationContexts();
     }
 
     void UiContainer::add( UiObject* uio )
@@ -52,6 +67,9 @@ namespace Heaven
     void UiContainer::add( UiObjectPrivate* uio )
     {
         mContent.append( uio );
+        uio->addedToContainer( this );
+
+        UiManager::self()->invalidateActivationContexts();
         setContainerDirty();
     }
 
@@ -66,6 +84,13 @@ namespace Heaven
                 setContainerDirty();
             }
         }
+
+        if( !mContent.contains( uio ) )
+        {
+            uio->removedFromContainer( this );
+        }
+
+        UiManager::self()->invalidateActivationContexts();
     }
 
     int UiContainer::numObjects() const
@@ -91,6 +116,34 @@ namespace Heaven
     void UiContainer::setContainerDirty( bool value )
     {
         mDirty = value;
+
+        if( value )
+        {
+            invalidateFlattened();
+            invalidateShortcuts();
+        }
+
+        if( !value || mPropagatingDirty )
+        {
+            return;
+        }
+
+        UiObjectTypes t = type();
+        if( t == ContainerType || t == ActionGroupType )
+        {
+            // We don't have widgets of our own; our content is emerged by whatever holds or
+            // merges us, so tell those.
+            mPropagatingDirty = true;
+
+            foreach( UiContainer* holder, mContainers )
+            {
+                holder->setContainerDirty();
+            }
+
+            MergesManager::self()->setContainerDirty( this );
+
+            mPropagatingDirty = false;
+        }
     }
 
     int UiContainer::priority() const
@@ -98,253 +151,393 @@ namespace Heaven
         return -1;
     }
 
-    bool UiContainer::mergeInto( QMenu* menu )
+    /**
+     * @internal
+     * @brief       Drop the cached flattened content of this container and of all it is part of
+     *
+     * The flattened content of a container includes the content of the ActionContainers in it
+     * and of the containers merged into its MergePlaces. So for an ActionContainer, the holders
+     * and the holders of the places it is merged into are invalidated as well. This follows the
+     * same paths as setContainerDirty(), but right away instead of when merges are flushed.
+     *
+     */
+    void UiContainer::invalidateFlattened()
     {
-        MenuPrivate* menuPriv;
-        ActionPrivate* actionPriv;
-        ActionGroupPrivate* actgrpPriv;
-        WidgetActionPrivate* widgetActPriv;
-        DynamicActionMergerPrivate* damPriv;
-        //ActionContainerPrivate* containerPriv;
-        //MergePlacePrivate* mergePlacePriv;
-
-        foreach( UiObjectPrivate* uio, allObjects() )
+        mFlattenedValid = false;
+
+        if( mInvalidatingFlattened )
         {
-            QAction* action;
+            // A container that (indirectly) contains itself.
+            return;
+        }
 
-            switch( uio->type() )
+        mInvalidatingFlattened = true;
+
+        if( type() == ContainerType )
+        {
+            foreach( UiContainer* holder, mContainers )
             {
-            case MenuType:
-                menuPriv = qobject_cast< MenuPrivate* >( uio );
-                Q_ASSERT( menuPriv );
-                action = menuPriv->getOrCreateQMenu( menu )->menuAction();
-                menu->addAction( action );
-                break;
+                holder->invalidateFlattened();
+            }
+        }
 
-            case ActionType:
-                actionPriv = qobject_cast< ActionPrivate* >( uio );
-                Q_ASSERT( actionPriv );
-                action = actionPriv->getOrCreateQAction( menu );
-                menu->addAction( action );
-                break;
+        MergesManager::self()->invalidateFlattened( this );
 
-            case ActionGroupType:
-                actgrpPriv = qobject_cast< ActionGroupPrivate* >(uio);
-                Q_ASSERT(actgrpPriv);
-                menu->addActions(actgrpPriv->groupForParent(menu)->actions());
-                break;
+        mInvalidatingFlattened = false;
+    }
 
-            case SeparatorType:
-                menu->addSeparator();
-                break;
+    /**
+     * @internal
+     * @brief       Drop the cached containsShortcuts() result of this container and its holders
+     *
+     * Whether a container contains shortcuts depends on everything below it, so the holders of
+     * this container and the holders of the places it is merged into are invalidated as well.
+     *
+     */
+    void UiContainer::invalidateShortcuts()
+    {
+        mShortcutsValid = false;
 
-            case WidgetActionType:
-                widgetActPriv = qobject_cast< WidgetActionPrivate* >( uio );
-                Q_ASSERT( widgetActPriv );
-                // We don't have to create several widget actions
-                menu->addAction( widgetActPriv->wrapper() );
-                break;
+        if( mInvalidatingShortcuts )
+        {
+            return;
+        }
 
-            case ContainerType:
-                ((UiContainer*)uio)->mergeInto( menu );
-                break;
+        mInvalidatingShortcuts = true;
 
-            case DynamicActionMergerType:
-                damPriv = qobject_cast< DynamicActionMergerPrivate* >( uio );
-                Q_ASSERT( damPriv );
-                damPriv->addActionsTo( menu );
+        foreach( UiContainer* holder, mContainers )
+        {
+            holder->invalidateShortcuts();
+        }
+
+        MergesManager::self()->invalidateShortcuts( this );
+
+        mInvalidatingShortcuts = false;
+    }
+
+    /**
+     * @internal
+     * @brief       Get the content of this container as it is emerged into a widget
+     *
+     * @return      All objects that end up in a widget, in order. Nested containers and the
+     *              containers merged into MergePlaces are expanded at arbitrary depth, so the list
+     *              only consists of menus, actions, action groups, widget actions, separators and
+     *              dynamic action mergers.
+     *
+     * The list is cached until this container is marked dirty (see invalidateFlattened()).
+     *
+     */
+    const UiContainer::FlatContent& UiContainer::flattenedContent()
+    {
+        if( !mFlattenedValid )
+        {
+            QSet< const UiContainer* > path;
+
+            mFlattened.clear();
+            flattenInto( mFlattened, path );
+
+            mFlattenedValid = true;
+        }
+
+        return mFlattened;
+    }
+
+    void UiContainer::flattenInto( FlatContent& content, QSet< const UiContainer* >& path )
+    {
+        if( path.contains( this ) )
+        {
+            // A container that (indirectly) contains itself.
+            return;
+        }
+        path.insert( this );
+
+        provideContent();
+
+        foreach( UiObjectPrivate* uio, mContent )
+        {
+            UiObjectTypes t = uio->type();
+
+            switch( t )
+            {
+            case ContainerType:
+                static_cast< UiContainer* >( uio )->flattenInto( content, path );
                 break;
 
             case MergePlaceType:
-                Q_ASSERT_X( false, "UiContainer", "MergePlace into Menu is unsupported!" );
+                foreach( UiContainer* merged, MergesManager::self()->mergedContainers(
+                             static_cast< MergePlacePrivate* >( uio )->mName ) )
+                {
+                    merged->flattenInto( content, path );
+                }
                 break;
 
             case MenuBarType:
             case ToolBarType:
-                Q_ASSERT_X( false, "UiContainer", "Cannot merge bars into Menus!" );
+                Q_ASSERT_X( false, "UiContainer", "Cannot merge bars into other containers!" );
+                break;
+
+            default:
+                content.append( FlatEntry( t, uio ) );
                 break;
             }
         }
-        return true;
-    }
 
+        // Only guard against cycles; a container may legitimately show up twice side by side.
+        path.remove( this );
+    }
 
-    bool UiContainer::mergeInto( QMenuBar* menuBar )
+    /**
+     * @internal
+     * @brief       Emerge the content of this container into a widget
+     *
+     * @param[in]   builder     The builder for the target QMenu, QMenuBar or QToolBar.
+     *
+     * This is the single place where the flattened content is turned into QActions, whatever the
+     * kind of the target widget is.
+     *
+     */
+    void UiContainer::emergeInto( ActionListBuilder& builder )
     {
-        MenuPrivate* menuPriv;
-        ActionPrivate* actionPriv;
-        ActionGroupPrivate* actgrpPriv;
-        WidgetActionPrivate* widgetActPriv;
-        //ActionContainerPrivate* containerPriv;
-        //MergePlacePrivate* mergePlacePriv;
-
-        foreach( UiObjectPrivate* uio, allObjects() )
-        {
-            QAction* action;
+        QWidget* widget = builder.widget();
+        bool intoMenu = qobject_cast< QMenu* >( widget ) != NULL;
 
-            switch( uio->type() )
+        // Copy; creating QActions must not be disturbed by someone changing our structure.
+        FlatContent content = flattenedContent();
+
+        foreach( const FlatEntry& entry, content )
+        {
+            switch( entry.mType )
             {
             case MenuType:
-                menuPriv = qobject_cast< MenuPrivate* >( uio );
-                Q_ASSERT( menuPriv );
-                action = menuPriv->getOrCreateQMenu( menuBar )->menuAction();
-                menuBar->addAction( action );
+                builder.addAction( static_cast< MenuPrivate* >( entry.mObject )
+                                   ->getOrCreateQMenu( widget )->menuAction() );
                 break;
 
             case ActionType:
-                actionPriv = qobject_cast< ActionPrivate* >( uio );
-                Q_ASSERT( actionPriv );
-                action = actionPriv->getOrCreateQAction( menuBar );
-                menuBar->addAction( action );
+                builder.addAction( static_cast< ActionPrivate* >( entry.mObject )
+                                   ->getOrCreateQAction( widget ) );
                 break;
 
             case ActionGroupType:
-                actgrpPriv = qobject_cast< ActionGroupPrivate* >(uio);
-                Q_ASSERT(actgrpPriv);
-                menuBar->addActions(actgrpPriv->groupForParent(menuBar)->actions());
+                builder.addActions( static_cast< ActionGroupPrivate* >( entry.mObject )
+                                    ->groupForParent( widget )->actions() );
                 break;
 
             case SeparatorType:
-                menuBar->addSeparator();
+                builder.addSeparator();
                 break;
 
             case WidgetActionType:
-                widgetActPriv = qobject_cast< WidgetActionPrivate* >( uio );
-                Q_ASSERT( widgetActPriv );
                 // We don't have to create several widget actions
-                menuBar->addAction( widgetActPriv->wrapper() );
-                break;
-
-            case ContainerType:
-                ((UiContainer*)uio)->mergeInto( menuBar );
+                builder.addAction( static_cast< WidgetActionPrivate* >( entry.mObject )
+                                   ->wrapper() );
                 break;
 
             case DynamicActionMergerType:
-                Q_ASSERT_X( false, "UiContainer", "Merging DAMs into Menubar is unsupported!" );
-                break;
-
-            case MergePlaceType:
-                Q_ASSERT_X( false, "UiContainer", "MergePlace into Toolbar is unsupported!" );
+                if( intoMenu )
+                {
+                    static_cast< DynamicActionMergerPrivate* >( entry.mObject )
+                            ->addActionsTo( builder );
+                }
+                else
+                {
+                    Q_ASSERT_X( false, "UiContainer", "Can't merge DAMs directly into bars" );
+                }
                 break;
 
-            case MenuBarType:
-            case ToolBarType:
-                Q_ASSERT_X( false, "UiContainer", "Cannot merge bars into bars!" );
+            default:
                 break;
             }
+        }
+    }
 
+    bool UiContainer::hasDynamicContent() const
+    {
+        foreach( UiObjectPrivate* uiop, allObjects() )
+        {
+            if( uiop->type() == DynamicActionMergerType )
+            {
+                return true;
+            }
         }
-        return true;
+
+        return false;
     }
 
-    bool UiContainer::mergeInto( QToolBar* toolBar )
+    bool UiContainer::containsShortcuts( QSet< const UiContainer* >& visited ) const
     {
-        MenuPrivate* menuPriv;
-        ActionPrivate* actionPriv;
-        ActionGroupPrivate* actgrpPriv;
-        WidgetActionPrivate* widgetActPriv;
-//		ActionContainerPrivate* containerPriv;
-//		MergePlacePrivate* mergePlacePriv;
-
-        foreach( UiObjectPrivate* uio, allObjects() )
+        if( visited.contains( this ) )
         {
-            QAction* action;
+            return false;
+        }
+        visited.insert( this );
+
+        if( mContentProvider )
+        {
+            // Don't create the content just to find out; the provider told us up front.
+            return mDeferredShortcuts;
+        }
 
+        foreach( UiObjectPrivate* uio, mContent )
+        {
             switch( uio->type() )
             {
-            case MenuType:
-                menuPriv = qobject_cast< MenuPrivate* >( uio );
-                Q_ASSERT( menuPriv );
-                action = menuPriv->getOrCreateQMenu( toolBar )->menuAction();
-                toolBar->addAction( action );
-                break;
-
             case ActionType:
-                actionPriv = qobject_cast< ActionPrivate* >( uio );
-                Q_ASSERT( actionPriv );
-                action = actionPriv->getOrCreateQAction( toolBar );
-                toolBar->addAction( action );
+                if( !static_cast< ActionPrivate* >( uio )->mShortcut.isEmpty() )
+                {
+                    return true;
+                }
                 break;
 
+            case MenuType:
+            case ContainerType:
             case ActionGroupType:
-                actgrpPriv = qobject_cast< ActionGroupPrivate* >(uio);
-                Q_ASSERT(actgrpPriv);
-                toolBar->addActions(actgrpPriv->groupForParent(toolBar)->actions());
+                if( static_cast< UiContainer* >( uio )->containsShortcuts( visited ) )
+                {
+                    return true;
+                }
                 break;
 
-            case WidgetActionType:
-                widgetActPriv = qobject_cast< WidgetActionPrivate* >( uio );
-                Q_ASSERT( widgetActPriv );
-                // We don't have to create several widget actions
-                toolBar->addAction( widgetActPriv->wrapper() );
+            case MergePlaceType:
+                foreach( UiContainer* merged, MergesManager::self()->mergedContainers(
+                             static_cast< MergePlacePrivate* >( uio )->mName ) )
+                {
+                    if( merged->containsShortcuts( visited ) )
+                    {
+                        return true;
+                    }
+                }
                 break;
 
-            case SeparatorType:
-                toolBar->addSeparator();
+            default:
                 break;
+            }
+        }
 
-            case ContainerType:
-                ((UiContainer*)uio)->mergeInto( toolBar );
-                break;
+        return false;
+    }
 
-            case DynamicActionMergerType:
-                Q_ASSERT_X( false, "UiContainer", "Merging DAMs into Toolbar is unsupported!" );
-                break;
+    /**
+     * @internal
+     * @brief       Check whether an Action with a shortcut is below this container
+     *
+     * @return      `true` if any Action in this container, in a nested container or in a
+     *              container merged into a nested MergePlace has a shortcut.
+     *
+     * The result is cached until this container or anything below it is marked dirty.
+     *
+     */
+    bool UiContainer::containsShortcuts()
+    {
+        if( !mShortcutsValid )
+        {
+            QSet< const UiContainer* > visited;
+            mHasShortcuts = containsShortcuts( visited );
+            mShortcutsValid = true;
+        }
 
-            case MergePlaceType:
-                Q_ASSERT_X( false, "UiContainer", "MergePlace into Toolbar is unsupported!" );
-                break;
+        return mHasShortcuts;
+    }
 
-            case MenuBarType:
-            case ToolBarType:
-                Q_ASSERT_X( false, "UiContainer", "Cannot merge bars into bars!" );
-                break;
-            }
+    /**
+     * @internal
+     * @brief       Defer the creation of this container's content
+     *
+     * @param[in]   provider            Function to call, once the content is needed. Pass `NULL` to
+     *                                  drop a provider that was not called yet.
+     *
+     * @param[in]   context             Passed to @a provider as is.
+     *
+     * @param[in]   containsShortcuts   Whether the content that @a provider will add contains any
+     *                                  Action with a shortcut. Until the content is provided, this
+     *                                  is what containsShortcuts() is based on.
+     *
+     */
+    void UiContainer::setContentProvider( UiObject::ContentProvider provider, void* context,
+                                          bool containsShortcuts )
+    {
+        mContentProvider = provider;
+        mContentContext = provider ? context : NULL;
+        mDeferredShortcuts = provider && containsShortcuts;
 
+        setContainerDirty();
+    }
+
+    /**
+     * @internal
+     * @brief       Call the content provider, if there is one
+     *
+     * The provider is called at most once; it is reset before being called, so that it may
+     * recurse into this container safely.
+     *
+     */
+    void UiContainer::provideContent()
+    {
+        if( !mContentProvider )
+        {
+            return;
         }
-        return true;
+
+        UiObject::ContentProvider provider = mContentProvider;
+        void* context = mContentContext;
+
+        mContentProvider = NULL;
+        mContentContext = NULL;
+        mDeferredShortcuts = false;
+
+        HEAVEN_TRACE_SCOPE( trace, "content", "UiContainer", mOwner );
+        provider( context, static_cast< UiObject* >( mOwner ) );
+        HEAVEN_TRACE_COUNT( trace, mContent.count() );
     }
 
-    bool UiContainer::hasDynamicContent() const
+    static bool findPathUpwards( UiContainer* top, UiObjectPrivate* from,
+                                 QList< UiContainer* >& path )
     {
-        foreach( UiObjectPrivate* uiop, allObjects() )
+        foreach( UiContainer* container, from->mContainers )
         {
-            if( uiop->type() == DynamicActionMergerType )
+            if( container == top )
             {
                 return true;
             }
+
+            if( path.contains( container ) )
+            {
+                // Guard against containers that (indirectly) contain themselves
+                continue;
+            }
+
+            path.prepend( container );
+            if( findPathUpwards( top, container, path ) )
+            {
+                return true;
+            }
+            path.removeFirst();
         }
 
         return false;
     }
 
+    /**
+     * @internal
+     * @brief       Find the containers that lie between this container and a child
+     *
+     * @param[in]   child   The object to search for.
+     *
+     * @return      The list of containers between this container and @a child, outermost first.
+     *              Neither this container nor @a child are part of the list. An empty list is
+     *              returned if @a child is a direct child or not contained at all.
+     *
+     * The path is found by walking upwards from @a child through the containers it has been added
+     * to. The cost is thus bound by the depth of the hierarchy and not by its total size.
+     *
+     */
     QList< UiContainer* > UiContainer::pathTo( UiObjectPrivate* child )
     {
         QList< UiContainer* > result;
 
-        if( this != child )
+        if( child && this != child && !findPathUpwards( this, child, result ) )
         {
-            foreach( UiObjectPrivate* cur, mContent )
-            {
-                if( cur == child )
-                {
-                    // direct child, return empty
-                    return result;
-                }
-
-                UiObjectTypes type = cur->type();
-                if( type == ToolBarType || type == MenuType || type == MenuBarType )
-                {
-                    UiContainer* sub = static_cast< UiContainer* >( cur );
-                    QList< UiContainer* > subPath = sub->pathTo( child );
-                    if( !subPath.isEmpty() )
-                    {
-                        result.append( this );
-                        result.append( subPath );
-                        break;
-                    }
-                }
-            }
+            result.clear();
         }
 
         return result;
@@ -18,11 +18,10 @@
 #define MGV_HEAVEN_UICONTAINER_H
 
 #include <QList>
+#include <QSet>
+#include <QVector>
 
-class QMenu;
-class QToolBar;
-class QMenuBar;
-
+#include "libHeavenActions/UiObject.hpp"
 #include "libHeavenActions/UiObjectPrivate.hpp"
 
 namespace Heaven
@@ -30,10 +29,12 @@ namespace Heaven
 
     class MenuPrivate;
     class UiObject;
+    class ActionListBuilder;
 
     class UiContainer : public UiObjectPrivate
     {
         friend class MenuPrivate;
+        friend class ActionIndex;
         Q_OBJECT
     protected:
         UiContainer( QObject* owner );
@@ -49,22 +50,66 @@ namespace Heaven
         virtual void setContainerDirty( bool value = true );
         virtual int priority() const;
 
-        virtual bool mergeInto( QMenu* menu );
-        virtual bool mergeInto( QMenuBar* menuBar );
-        virtual bool mergeInto( QToolBar* toolBar );
+        void emergeInto( ActionListBuilder& builder );
 
         QList< UiContainer* > pathTo( UiObjectPrivate* child );
 
         bool hasDynamicContent() const;
+        bool containsShortcuts();
+
+        void setContentProvider( UiObject::ContentProvider provider, void* context,
+                                 bool containsShortcuts );
+        void provideContent();
 
     protected:
         int numObjects() const;
         UiObjectPrivate* objectAt( int index );
         QList< UiObjectPrivate* > allObjects() const;
 
+    public:
+        void invalidateFlattened();
+        void invalidateShortcuts();
+
+    private:
+        struct FlatEntry
+        {
+            FlatEntry()
+                : mType( ActionType )
+                , mObject( NULL )
+            {
+            }
+
+            FlatEntry( UiObjectTypes type, UiObjectPrivate* object )
+                : mType( type )
+                , mObject( object )
+            {
+            }
+
+            UiObjectTypes       mType;
+            UiObjectPrivate*    mObject;
+        };
+
+        typedef QVector< FlatEntry > FlatContent;
+
+        const FlatContent& flattenedContent();
+        void flattenInto( FlatContent& content, QSet< const UiContainer* >& path );
+
+    private:
+        bool containsShortcuts( QSet< const UiContainer* >& visited ) const;
+
     private:
         bool                        mDirty;
+        bool                        mPropagatingDirty;
+        bool                        mFlattenedValid;
+        bool                        mInvalidatingFlattened;
         QList< UiObjectPrivate* >   mContent;
+        FlatContent                 mFlattened;
+        UiObject::ContentProvider   mContentProvider;
+        void*                       mContentContext;
+        bool                        mDeferredShortcuts;
+        bool                        mShortcutsValid;
+        bool                        mHasShortcuts;
+        bool                        mInvalidatingShortcuts;
     };
 
 }
@@ -0,0 +1,468 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <string.h>
+
+#include <QFile>
+#include <QHash>
+#include <QPointer>
+#include <QVector>
+#include <QMetaObject>
+
+#include "libHeavenActions/UiLoader.hpp"
+#include "libHeavenActions/UiBuilder.hpp"
+#include "libHeavenActions/UiObject.hpp"
+#include "libHeavenActions/UiObjectArena.hpp"
+
+namespace Heaven
+{
+
+    /**
+     * @class       UiLoader
+     * @brief       Instantiates Uis from a binary file at runtime
+     *
+     * `hic --binary` (or the HIC_BINARY cmake macro) serializes the Uis of a .hid file into the
+     * same tables that `--tables` generates as source code. UiLoader maps such a file into
+     * memory, checks it and hands the tables to UiBuilder. There is no text to parse, so this is
+     * meant for plugins that bring their Uis along without linking hic generated code.
+     *
+     * Since there is no C++ code to check them at compile time, the slots and signals the actions
+     * and mergers connect to are looked up in the meta object of the parent before anything is
+     * created.
+     *
+     * The created objects are children of the parent passed to load(); the loader may be
+     * destroyed before them.
+     *
+     */
+
+    // See hic/HIGenBinary.h for the layout
+    static const quint16 sBinaryVersion     = 1;
+    static const quint16 sByteOrderMark     = 0x0102;
+    static const quint32 sNoString          = 0xFFFFFFFF;
+
+    static const quint32 sHeaderSize        = 24;
+    static const quint32 sUiSize            = 32;
+    static const quint32 sObjectSize        = 8;
+    static const quint32 sPropertySize      = 12;
+    static const quint32 sContentSize       = 4;
+
+    struct UiLoaderUi
+    {
+        const char*                         mTrContext;
+        QVector< UiObjectDescriptor >       mObjects;
+        QVector< UiPropertyDescriptor >     mProperties;
+        QVector< UiContentDescriptor >      mContent;
+    };
+
+    class UiLoaderData
+    {
+    public:
+        bool fail( const QString& error );
+        bool loadData( const uchar* data, quint32 size, QObject* parent );
+        bool readUi( const uchar* data, quint32 size, quint32 ui, QObject* parent,
+                     UiLoaderUi& result );
+        void buildUi( const UiLoaderUi& ui, QObject* parent );
+        bool checkString( quint32 offset, bool optional );
+        bool checkTable( quint32 offset, quint32 count, quint32 entrySize, quint32 size );
+        bool checkMethod( QObject* parent, const char* signature, bool isSignal );
+        bool checkMergerSlot( QObject* parent, const char* name );
+
+    public:
+        UiObjectArena                       mArena;
+        QString                             mErrorString;
+        QHash< QString, QPointer< UiObject > > mObjects;
+        const char*                         mStringPool;
+        quint32                             mStringPoolSize;
+    };
+
+    static quint16 read16( const uchar* data, quint32 offset )
+    {
+        quint16 value;
+        memcpy( &value, data + offset, sizeof( value ) );
+        return value;
+    }
+
+    static quint32 read32( const uchar* data, quint32 offset )
+    {
+        quint32 value;
+        memcpy( &value, data + offset, sizeof( value ) );
+        return value;
+    }
+
+    bool UiLoaderData::fail( const QString& error )
+    {
+        mErrorString = error;
+        return false;
+    }
+
+    bool UiLoaderData::checkString( quint32 offset, bool optional )
+    {
+        if( offset == sNoString )
+        {
+            return optional;
+        }
+
+        // The pool ends with a NUL, so every string in it is terminated.
+        return offset < mStringPoolSize;
+    }
+
+    bool UiLoaderData::checkTable( quint32 offset, quint32 count, quint32 entrySize, quint32 size )
+    {
+        return offset <= size && count <= ( size - offset ) / entrySize;
+    }
+
+    bool UiLoaderData::checkMethod( QObject* parent, const char* signature, bool isSignal )
+    {
+        QByteArray normalized = QMetaObject::normalizedSignature( signature );
+        const QMetaObject* mo = parent->metaObject();
+
+        int index = isSignal ? mo->indexOfSignal( normalized.constData() )
+                             : mo->indexOfMethod( normalized.constData() );
+        if( index != -1 )
+        {
+            return true;
+        }
+
+        return fail( QString( QLatin1String( "%1 has no %2 %3" ) )
+                     .arg( QLatin1String( mo->className() ) )
+                     .arg( QLatin1String( isSignal ? "signal" : "slot" ) )
+                     .arg( QString::fromUtf8( signature ) ) );
+    }
+
+    /**
+     * @internal
+     * @brief       Check that the parent has a slot a DynamicActionMerger can invoke
+     *
+     * The merger invokes its slot by name, with the merger as argument, and in paged mode with the
+     * first index and the number of entries to add in addition. Either of both is fine.
+     *
+     */
+    bool UiLoaderData::checkMergerSlot( QObject* parent, const char* name )
+    {
+        if( strchr( name, '(' ) )
+        {
+            return checkMethod( parent, name, false );
+        }
+
+        const QMetaObject* mo = parent->metaObject();
+        QByteArray simple = QByteArray( name ) + "(Heaven::DynamicActionMerger*)";
+        QByteArray paged = QByteArray( name ) + "(Heaven::DynamicActionMerger*,int,int)";
+
+        if( mo->indexOfMethod( simple.constData() ) != -1 ||
+            mo->indexOfMethod( paged.constData() ) != -1 )
+        {
+            return true;
+        }
+
+        return fail( QString( QLatin1String( "%1 has no slot %2(Heaven::DynamicActionMerger*)" ) )
+                     .arg( QLatin1String( mo->className() ) )
+                     .arg( QString::fromUtf8( name ) ) );
+    }
+
+    bool UiLoaderData::loadData( const uchar* data, quint32 size, QObject* parent )
+    {
+        if( size < sHeaderSize || memcmp( data, "HIDB", 4 ) != 0 )
+        {
+            return fail( QLatin1String( "Not a binary Ui file" ) );
+        }
+
+        if( read16( data, 6 ) != sByteOrderMark )
+        {
+            return fail( QLatin1String( "The binary Ui file was created for another byte order" ) );
+        }
+
+        if( read16( data, 4 ) != sBinaryVersion )
+        {
+            return fail( QString( QLatin1String( "Unsupported binary Ui version %1" ) )
+                         .arg( read16( data, 4 ) ) );
+        }
+
+        quint32 uiCount = read32( data, 8 );
+        quint32 uiTable = read32( data, 12 );
+        quint32 pool = read32( data, 16 );
+        mStringPoolSize = read32( data, 20 );
+
+        if( !checkTable( uiTable, uiCount, sUiSize, size ) ||
+            !checkTable( pool, mStringPoolSize, 1, size ) ||
+            ( mStringPoolSize && data[ pool + mStringPoolSize - 1 ] != '\0' ) )
+        {
+            return fail( QLatin1String( "The binary Ui file is corrupt" ) );
+        }
+
+        mStringPool = reinterpret_cast< const char* >( data + pool );
+
+        // Check all Uis before creating anything, so a bad Ui doesn't leave the ones before it
+        // half created.
+        QVector< UiLoaderUi > uis( int( uiCount ) );
+
+        for( quint32 i = 0; i < uiCount; i++ )
+        {
+            if( !readUi( data, size, uiTable + i * sUiSize, parent, uis[ int( i ) ] ) )
+            {
+                return false;
+            }
+        }
+
+        foreach( const UiLoaderUi& ui, uis )
+        {
+            buildUi( ui, parent );
+        }
+
+        return true;
+    }
+
+    bool UiLoaderData::readUi( const uchar* data, quint32 size, quint32 ui, QObject* parent,
+                               UiLoaderUi& result )
+    {
+        quint32 trContext = read32( data, ui + 4 );
+        quint32 objectCount = read32( data, ui + 8 );
+        quint32 objects = read32( data, ui + 12 );
+        quint32 propertyCount = read32( data, ui + 16 );
+        quint32 properties = read32( data, ui + 20 );
+        quint32 contentCount = read32( data, ui + 24 );
+        quint32 content = read32( data, ui + 28 );
+
+        QString corrupt = QLatin1String( "The binary Ui file is corrupt" );
+
+        if( !checkString( trContext, false ) || objectCount >= UiContentSeparator ||
+            !checkTable( objects, objectCount, sObjectSize, size ) ||
+            !checkTable( properties, propertyCount, sPropertySize, size ) ||
+            !checkTable( content, contentCount, sContentSize, size ) )
+        {
+            return fail( corrupt );
+        }
+
+        QVector< UiObjectDescriptor >& objectDescs = result.mObjects;
+        QVector< UiPropertyDescriptor >& propertyDescs = result.mProperties;
+        QVector< UiContentDescriptor >& contentDescs = result.mContent;
+
+        objectDescs.resize( int( objectCount ) );
+        propertyDescs.resize( int( propertyCount ) );
+        contentDescs.resize( int( contentCount ) );
+
+        for( quint32 i = 0; i < objectCount; i++ )
+        {
+            quint32 entry = objects + i * sObjectSize;
+            UiObjectDescriptor& desc = objectDescs[ i ];
+
+            desc.mKind = read16( data, entry );
+            quint32 name = read32( data, entry + 4 );
+
+            if( desc.mKind > UiDescDynamicActionMerger || !checkString( name, false ) )
+            {
+                return fail( corrupt );
+            }
+
+            desc.mName = mStringPool + name;
+        }
+
+        for( quint32 i = 0; i < propertyCount; i++ )
+        {
+            quint32 entry = properties + i * sPropertySize;
+            UiPropertyDescriptor& desc = propertyDescs[ i ];
+
+            desc.mObject = read16( data, entry );
+            desc.mProperty = data[ entry + 2 ];
+            desc.mTranslate = data[ entry + 3 ];
+            quint32 string = read32( data, entry + 4 );
+            desc.mValue = int( read32( data, entry + 8 ) );
+
+            // Only shortcuts and the plain values may come without a string
+            bool optional = desc.mProperty == UiPropShortcut ||
+                            desc.mProperty == UiPropMenuRole ||
+                            ( desc.mProperty >= UiPropCheckable &&
+                              desc.mProperty <= UiPropEnabled ) ||
+                            desc.mProperty == UiPropShortcutContext ||
+                            desc.mProperty == UiPropMergePriority;
+
+            if( desc.mObject >= objectCount || desc.mProperty > UiPropMergeInto ||
+                !checkString( string, optional ) )
+            {
+                return fail( corrupt );
+            }
+
+            desc.mString = string == sNoString ? NULL : mStringPool + string;
+
+            if( desc.mProperty == UiPropConnectTo &&
+                !checkMethod( parent, desc.mString, false ) )
+            {
+                return false;
+            }
+
+            if( desc.mProperty == UiPropRebuildSignal &&
+                !checkMethod( parent, desc.mString, true ) )
+            {
+                return false;
+            }
+
+            if( desc.mProperty == UiPropMergerSlot && !checkMergerSlot( parent, desc.mString ) )
+            {
+                return false;
+            }
+        }
+
+        for( quint32 i = 0; i < contentCount; i++ )
+        {
+            quint32 entry = content + i * sContentSize;
+            UiContentDescriptor& desc = contentDescs[ i ];
+
+            desc.mContainer = read16( data, entry );
+            desc.mChild = read16( data, entry + 2 );
+
+            if( desc.mContainer >= objectCount ||
+                ( desc.mChild >= objectCount && desc.mChild != UiContentSeparator ) )
+            {
+                return fail( corrupt );
+            }
+        }
+
+        result.mTrContext = mStringPool + trContext;
+        return true;
+    }
+
+    void UiLoaderData::buildUi( const UiLoaderUi& ui, QObject* parent )
+    {
+        UiDescriptor descriptor;
+        descriptor.mTrContext = ui.mTrContext;
+        descriptor.mObjects = ui.mObjects.constData();
+        descriptor.mObjectCount = ui.mObjects.count();
+        descriptor.mProperties = ui.mProperties.constData();
+        descriptor.mPropertyCount = ui.mProperties.count();
+        descriptor.mContent = ui.mContent.constData();
+        descriptor.mContentCount = ui.mContent.count();
+
+        QVector< UiObject* > created( ui.mObjects.count() );
+
+        {
+            UiObjectArena::Scope arenaScope( mArena );
+            UiBuilder::build( descriptor, parent, created.data() );
+        }
+
+        foreach( UiObject* obj, created )
+        {
+            if( obj )
+            {
+                mObjects.insert( obj->objectName(), obj );
+            }
+        }
+    }
+
+    UiLoader::UiLoader()
+        : d( new UiLoaderData )
+    {
+        d->mStringPool = NULL;
+        d->mStringPoolSize = 0;
+    }
+
+    UiLoader::~UiLoader()
+    {
+        delete d;
+    }
+
+    /**
+     * @brief       Load all Uis from a binary Ui file
+     *
+     * @param[in]   fileName    The file to load, as written by `hic --binary`. This may be a Qt
+     *                          resource path.
+     *
+     * @param[in]   parent      The QObject to parent the created objects to. The actions connect
+     *                          to its slots and the mergers rebuild on its signals.
+     *
+     * @return      `true` on success. Otherwise errorString() tells what went wrong. The file is
+     *              completely checked before any object of a Ui is created.
+     *
+     */
+    bool UiLoader::load( const QString& fileName, QObject* parent )
+    {
+        d->mErrorString = QString();
+
+        if( !parent )
+        {
+            return d->fail( QLatin1String( "A parent is required to load a Ui" ) );
+        }
+
+        QFile f( fileName );
+        if( !f.open( QFile::ReadOnly ) )
+        {
+            return d->fail( f.errorString() );
+        }
+
+        if( f.size() > qint64( 0x7FFFFFFF ) )
+        {
+            return d->fail( QLatin1String( "The binary Ui file is too large" ) );
+        }
+
+        quint32 size = quint32( f.size() );
+
+        // Everything is used right from the mapping; only files that cannot be mapped are read.
+        QByteArray buffer;
+        const uchar* data = f.map( 0, size );
+        if( !data )
+        {
+            buffer = f.readAll();
+            data = reinterpret_cast< const uchar* >( buffer.constData() );
+        }
+
+        bool result = d->loadData( data, size, parent );
+
+        d->mStringPool = NULL;
+        d->mStringPoolSize = 0;
+
+        return result;
+    }
+
+    /**
+     * @brief       Get a description of the last error
+     *
+     * @return      Why the last call to load() failed or an empty string if it succeeded.
+     *
+     */
+    QString UiLoader::errorString() const
+    {
+        return d->mErrorString;
+    }
+
+    /**
+     * @brief       Find a loaded object
+     *
+     * @param[in]   name    The object name, which is the name in the .hid file with the same
+     *                      prefix as the member of a hic generated class (e.g. `actFoo`).
+     *
+     * @return      The object or `NULL`, if there is no such object or it was deleted.
+     *
+     */
+    UiObject* UiLoader::object( const QString& name ) const
+    {
+        return d->mObjects.value( name );
+    }
+
+    QList< UiObject* > UiLoader::objects() const
+    {
+        QList< UiObject* > result;
+
+        foreach( const QPointer< UiObject >& obj, d->mObjects )
+        {
+            if( obj )
+            {
+                result.append( obj );
+            }
+        }
+
+        return result;
+    }
+
+}
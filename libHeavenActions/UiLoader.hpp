@@ -0,0 +1,54 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef MGV_HEAVEN_UI_LOADER_H
+#define MGV_HEAVEN_UI_LOADER_H
+
+#include <QString>
+#include <QList>
+
+#include "libHeavenActions/libHeavenActionsAPI.hpp"
+
+class QObject;
+
+namespace Heaven
+{
+
+    class UiObject;
+    class UiLoaderData;
+
+    class HEAVEN_ACTIONS_API UiLoader
+    {
+    public:
+        UiLoader();
+        ~UiLoader();
+
+    public:
+        bool load( const QString& fileName, QObject* parent );
+        QString errorString() const;
+
+        UiObject* object( const QString& name ) const;
+        QList< UiObject* > objects() const;
+
+    private:
+        Q_DISABLE_COPY( UiLoader )
+        UiLoaderData* d;
+    };
+
+}
+
+#endif
@@ -14,16 +14,26 @@
  *
  */
 
+#include <QApplication>
 #include <QWidget>
+#include <QAction>
+#include <QMenu>
+#include <QMenuBar>
+#include <QShortcut>
 
 #include "libHeavenActions/UiManager.hpp"
 #include "libHeavenActions/UiContainer.hpp"
+#include "libHeavenActions/ActionPrivate.hpp"
 
 namespace Heaven
 {
 
     UiManager::UiManager()
         : QObject()
+        , mActionBatchDepth( 0 )
+        , mStateEvaluationQueued( false )
+        , mTrackingFocus( false )
+        , mShortcutRefreshQueued( false )
     {
     }
 
@@ -62,14 +72,465 @@ namespace Heaven
     void UiManager::addCreatedObject( QObject* object, UiObjectPrivate* forUiObject )
     {
         mCreatedObjects.insert( object, forUiObject );
+        invalidateActivationContexts();
     }
 
     void UiManager::removeCreatedObject( QObject* object )
     {
         mCreatedObjects.remove( object );
+        invalidateActivationContexts();
     }
 
+    ActionIndex* UiManager::actionIndex()
+    {
+        return &mActionIndex;
+    }
+
+    void UiManager::beginActionBatch()
+    {
+        mActionBatchDepth++;
+    }
+
+    void UiManager::endActionBatch()
+    {
+        Q_ASSERT( mActionBatchDepth > 0 );
+
+        if( --mActionBatchDepth > 0 )
+        {
+            return;
+        }
+
+        // Take them one at a time: Flushing one action might delete another one as a side effect,
+        // which removes it from the set via cancelActionUpdate().
+        while( !mPendingActions.isEmpty() )
+        {
+            QSet< ActionPrivate* >::iterator it = mPendingActions.begin();
+            ActionPrivate* action = *it;
+            mPendingActions.erase( it );
+
+            action->flushProperties();
+        }
+    }
+
+    bool UiManager::isBatchingActions() const
+    {
+        return mActionBatchDepth > 0;
+    }
+
+    void UiManager::queueActionUpdate( ActionPrivate* action )
+    {
+        mPendingActions.insert( action );
+    }
+
+    void UiManager::cancelActionUpdate( ActionPrivate* action )
+    {
+        mPendingActions.remove( action );
+        mStaleActions.remove( action );
+        mEvaluatingActions.remove( action );
+    }
+
+    void UiManager::invalidateActionState( ActionPrivate* action )
+    {
+        mStaleActions.insert( action );
+
+        if( !mStateEvaluationQueued )
+        {
+            mStateEvaluationQueued = true;
+            QMetaObject::invokeMethod( this, "evaluateActionStates", Qt::QueuedConnection );
+        }
+    }
+
+    /**
+     * @internal
+     * @brief       Evaluate the state predicates of all stale actions that have QActions
+     *
+     * Actions without QActions stay stale; they are evaluated when their first QAction is
+     * created. All resulting property changes are applied in a single ActionBatchUpdate.
+     *
+     */
+    void UiManager::evaluateActionStates()
+    {
+        mStateEvaluationQueued = false;
+
+        // Actions that get invalidated while we evaluate end up in mStaleActions again and are
+        // handled in the next pass.
+        mEvaluatingActions = mStaleActions;
+        mStaleActions.clear();
+
+        ActionBatchUpdate batch;
+
+        while( !mEvaluatingActions.isEmpty() )
+        {
+            QSet< ActionPrivate* >::iterator it = mEvaluatingActions.begin();
+            ActionPrivate* action = *it;
+            mEvaluatingActions.erase( it );
+
+            if( action->mStateDirty && action->isMaterialized() )
+            {
+                action->evaluateState();
+            }
+        }
+    }
+
+    /**
+     * @internal
+     * @brief       Find the widget a QAction is shown in
+     *
+     * QMenus are top level popups, so for QActions inside a menu we follow the menu's parent
+     * widgets up to the menu bar or tool bar that opens it.
+     *
+     */
+    static QWidget* shortcutAnchorOf( QAction* act )
+    {
+        QWidget* w = qobject_cast< QWidget* >( act->parent() );
+        while( w && qobject_cast< QMenu* >( w ) )
+        {
+            w = w->parentWidget();
+        }
+
+        return w;
+    }
+
+    /**
+     * @internal
+     * @brief       Find the widget that hosts the shortcut of a QAction
+     *
+     * @param[in]   act     The QAction whose shortcut is to be hosted.
+     *
+     * @return      The window the QAction lives in or `NULL` if none could be determined.
+     *
+     */
+    QWidget* UiManager::shortcutHostFor( QAction* act )
+    {
+        QWidget* w = shortcutAnchorOf( act );
+        if( !w )
+        {
+            return NULL;
+        }
+
+        w = w->window();
+        if( qobject_cast< QMenu* >( w ) || qobject_cast< QMenuBar* >( w ) )
+        {
+            // A parentless menu or a native menu bar; Qt's own lookup knows better here.
+            return NULL;
+        }
+
+        return w;
+    }
+
+    /**
+     * @internal
+     * @brief       Register the shortcut of a QAction with the shortcut index
+     *
+     * @param[in]   action  The action the QAction was created for.
+     *
+     * @param[in]   act     The QAction to register.
+     *
+     * @return      `true` if the shortcut is now dispatched by the index. In this case the caller
+     *              must not set the shortcut on the QAction itself. `false` if the QAction has to
+     *              register the shortcut on its own.
+     *
+     * All QActions with the same key sequence that live in the same window share one QShortcut.
+     * When it is activated, shortcutTarget() picks the QAction to trigger, which in turn finds its
+     * activation context just as if it had been triggered from its menu.
+     *
+     * Only window shortcuts are handled here. For widget shortcuts the focus widget decides and
+     * that is exactly what Qt's per-QAction lookup does. Application shortcuts are not bound to a
+     * window we could host them in, so they are left to Qt as well.
+     *
+     */
+    bool UiManager::registerShortcut( ActionPrivate* action, QAction* act )
+    {
+        if( action->mShortcut.isEmpty() || action->mShortcutContext != Qt::WindowShortcut )
+        {
+            return false;
+        }
+
+        if( !mTrackingFocus && qApp )
+        {
+            // Which target a shortcut goes to depends on the focus widget
+            mTrackingFocus = true;
+            connect( qApp, SIGNAL(focusChanged(QWidget*,QWidget*)),
+                     this, SLOT(focusChanged(QWidget*,QWidget*)) );
+        }
+
+        QWidget* host = shortcutHostFor( act );
+        if( !host )
+        {
+            return false;
+        }
+
+        ShortcutKey key( host, action->mShortcut.toString( QKeySequence::PortableText ) );
+        ShortcutEntry& entry = mShortcuts[ key ];
+
+        if( !entry.mShortcut )
+        {
+            entry.mShortcut = new QShortcut( action->mShortcut, host );
+            entry.mShortcut->setContext( action->mShortcutContext );
+            mShortcutKeys.insert( entry.mShortcut, key );
+
+            connect( entry.mShortcut, SIGNAL(activated()), this, SLOT(shortcutActivated()) );
+            connect( entry.mShortcut, SIGNAL(destroyed()), this, SLOT(shortcutDestroyed()) );
+        }
+
+        entry.mTargets.append( act );
+        mShortcutTargets.insert( act, key );
+
+        refreshShortcut( act );
+        return true;
+    }
+
+    void UiManager::unregisterShortcut( QAction* act )
+    {
+        QHash< QAction*, ShortcutKey >::iterator it = mShortcutTargets.find( act );
+        if( it == mShortcutTargets.end() )
+        {
+            return;
+        }
+
+        ShortcutKey key = it.value();
+        mShortcutTargets.erase( it );
+
+        QHash< ShortcutKey, ShortcutEntry >::iterator entry = mShortcuts.find( key );
+        if( entry == mShortcuts.end() )
+        {
+            return;
+        }
+
+        entry->mTargets.removeAll( act );
+
+        if( entry->mTargets.isEmpty() )
+        {
+            QShortcut* shortcut = entry->mShortcut;
+            mShortcuts.erase( entry );
+            mShortcutKeys.remove( shortcut );
+
+            shortcut->disconnect( this );
+            delete shortcut;
+            return;
+        }
+
+        // The QAction might have been the only enabled one.
+        refreshShortcut( entry->mTargets.first() );
+    }
+
+    bool UiManager::isShortcutTarget( QAction* act ) const
+    {
+        return mShortcutTargets.contains( act );
+    }
+
+    /**
+     * @internal
+     * @brief       Pick the QAction a shortcut is to trigger
+     *
+     * @return      The target or `NULL` if none of the targets is applicable right now.
+     *
+     * Only enabled and visible targets shown in a visible widget are applicable. Of these, a
+     * target whose activation context is a widget applies only if that widget contains the focus
+     * widget; if several do, the innermost context wins. Targets without a widget as activation
+     * context apply to the whole window and are only used if no such target applies.
+     *
+     */
+    QAction* UiManager::shortcutTarget( const ShortcutEntry& entry )
+    {
+        QWidget* focus = QApplication::focusWidget();
+        QAction* best = NULL;
+        QWidget* bestContext = NULL;
+        QAction* fallback = NULL;
+
+        foreach( QAction* target, entry.mTargets )
+        {
+            if( !target->isEnabled() || !target->isVisible() )
+            {
+                continue;
+            }
+
+            QWidget* anchor = shortcutAnchorOf( target );
+            if( !anchor || !anchor->isVisible() )
+            {
+                continue;
+            }
+
+            QWidget* context = qobject_cast< QWidget* >( findActivationContext( target ) );
+            if( !context )
+            {
+                if( !fallback )
+                {
+                    fallback = target;
+                }
+                continue;
+            }
+
+            if( !focus || ( context != focus && !context->isAncestorOf( focus ) ) )
+            {
+                continue;
+            }
+
+            if( !best || bestContext->isAncestorOf( context ) )
+            {
+                best = target;
+                bestContext = context;
+            }
+        }
+
+        return best ? best : fallback;
+    }
+
+    /**
+     * @internal
+     * @brief       Update the enabled state of the QShortcut a QAction is dispatched by
+     *
+     * A QShortcut without an applicable target must be disabled itself. Otherwise it would
+     * swallow the key press instead of letting Qt offer it to other shortcuts or the focus widget.
+     *
+     */
+    void UiManager::refreshShortcut( QAction* act )
+    {
+        QHash< QAction*, ShortcutKey >::const_iterator it = mShortcutTargets.constFind( act );
+        if( it == mShortcutTargets.constEnd() )
+        {
+            return;
+        }
+
+        refreshShortcutEntry( mShortcuts[ it.value() ] );
+    }
+
+    void UiManager::refreshShortcutEntry( const ShortcutEntry& entry )
+    {
+        entry.mShortcut->setEnabled( shortcutTarget( entry ) != NULL );
+    }
+
+    void UiManager::refreshShortcuts()
+    {
+        mShortcutRefreshQueued = false;
+
+        foreach( const ShortcutEntry& entry, mShortcuts )
+        {
+            refreshShortcutEntry( entry );
+        }
+    }
+
+    void UiManager::focusChanged( QWidget* old, QWidget* now )
+    {
+        QWidget* oldWindow = old ? old->window() : NULL;
+        QWidget* newWindow = now ? now->window() : NULL;
+
+        QHash< ShortcutKey, ShortcutEntry >::const_iterator it;
+        for( it = mShortcuts.constBegin(); it != mShortcuts.constEnd(); ++it )
+        {
+            if( it.key().first == oldWindow || it.key().first == newWindow )
+            {
+                refreshShortcutEntry( it.value() );
+            }
+        }
+    }
+
+    void UiManager::shortcutActivated()
+    {
+        QHash< QObject*, ShortcutKey >::const_iterator it = mShortcutKeys.constFind( sender() );
+        if( it == mShortcutKeys.constEnd() )
+        {
+            return;
+        }
+
+        QAction* target = shortcutTarget( mShortcuts.value( it.value() ) );
+        if( target )
+        {
+            target->trigger();
+        }
+    }
+
+    void UiManager::shortcutDestroyed()
+    {
+        // The window hosting the shortcut is going away, taking all targets with it.
+        ShortcutKey key = mShortcutKeys.take( sender() );
+        ShortcutEntry entry = mShortcuts.take( key );
+
+        foreach( QAction* target, entry.mTargets )
+        {
+            mShortcutTargets.remove( target );
+        }
+    }
+
+    /**
+     * @internal
+     * @brief       Drop all cached activation contexts
+     *
+     * Must be called whenever something changes that the result of findActivationContext() depends
+     * on: The content of a container, an activation context or the set of created objects. Changes
+     * to the QObject hierarchy are detected by findActivationContext() itself.
+     *
+     */
+    void UiManager::invalidateActivationContexts()
+    {
+        mActivationContexts.clear();
+
+        // Which shortcut targets apply depends on the activation contexts
+        if( !mShortcutRefreshQueued && !mShortcuts.isEmpty() )
+        {
+            mShortcutRefreshQueued = true;
+            QMetaObject::invokeMethod( this, "refreshShortcuts", Qt::QueuedConnection );
+        }
+    }
+
+    /**
+     * @internal
+     * @brief       Find the activation context for a triggered QObject
+     *
+     * @param[in]   trigger     The QObject (typically a QAction) that was triggered.
+     *
+     * @return      The activation context or `NULL` if none was found.
+     *
+     * Results are cached per created object until invalidateActivationContexts() is called.
+     * Along with a result, the chain of parents that led to it is cached. That chain is checked on
+     * every lookup, which costs a few pointer compares, so created objects that were reparented
+     * are resolved anew without having to watch all their events.
+     *
+     */
     QObject* UiManager::findActivationContext( QObject* trigger )
+    {
+        Q_ASSERT( trigger );
+
+        QHash< QObject*, CachedActivationContext >::const_iterator it =
+                mActivationContexts.constFind( trigger );
+
+        if( it != mActivationContexts.constEnd() )
+        {
+            const QVector< QObject* >& chain = it->mChain;
+            bool valid = true;
+
+            // All but the last one are created objects, which remove themselves when deleted.
+            for( int i = 0; valid && i + 1 < chain.count(); i++ )
+            {
+                valid = chain[ i ]->parent() == chain[ i + 1 ];
+            }
+
+            if( valid )
+            {
+                return it->mContext;
+            }
+        }
+
+        CachedActivationContext cached;
+        cached.mContext = resolveActivationContext( trigger, cached.mChain );
+
+        if( mCreatedObjects.contains( trigger ) )
+        {
+            mActivationContexts.insert( trigger, cached );
+        }
+
+        return cached.mContext;
+    }
+
+    /**
+     * @internal
+     * @brief       Resolve the activation context for a triggered QObject
+     *
+     * @param[out]  chain   Receives @a trigger and the parents that were followed from it. If the
+     *                      topmost one had no parent, a `NULL` is appended.
+     *
+     */
+    QObject* UiManager::resolveActivationContext( QObject* trigger, QVector< QObject* >& chain )
     {
         UiObjectPrivate* previous;
         UiObjectPrivate* uiObject = NULL;
@@ -77,6 +538,8 @@ namespace Heaven
 
         do
         {
+            chain.append( trigger );
+
             previous = uiObject;
             uiObject = mCreatedObjects.value( trigger, NULL );
             if( !uiObject )
@@ -107,6 +570,7 @@ namespace Heaven
             trigger = trigger->parent();
         } while( trigger );
 
+        chain.append( NULL );
         return NULL;
     }
 
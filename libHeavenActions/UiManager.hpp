@@ -20,11 +20,22 @@
 #include <QObject>
 #include <QHash>
 #include <QSet>
+#include <QList>
+#include <QVector>
+#include <QPair>
+#include <QString>
+
+class QAction;
+class QShortcut;
+class QWidget;
+
+#include "libHeavenActions/ActionIndex.hpp"
 
 namespace Heaven
 {
 
     class UiObjectPrivate;
+    class ActionPrivate;
 
     class UiManager : public QObject
     {
@@ -42,14 +53,75 @@ namespace Heaven
 
     public:
         QObject* findActivationContext( QObject* trigger );
+        void invalidateActivationContexts();
         void addCreatedObject( QObject* object, UiObjectPrivate* forUiObject );
         void removeCreatedObject( QObject* object );
 
+    public:
+        void beginActionBatch();
+        void endActionBatch();
+        bool isBatchingActions() const;
+        void queueActionUpdate( ActionPrivate* action );
+        void cancelActionUpdate( ActionPrivate* action );
+        void invalidateActionState( ActionPrivate* action );
+
+    public:
+        ActionIndex* actionIndex();
+
+    public:
+        bool registerShortcut( ActionPrivate* action, QAction* act );
+        void unregisterShortcut( QAction* act );
+        void refreshShortcut( QAction* act );
+        bool isShortcutTarget( QAction* act ) const;
+
+    private slots:
+        void evaluateActionStates();
+        void shortcutActivated();
+        void shortcutDestroyed();
+        void refreshShortcuts();
+        void focusChanged( QWidget* old, QWidget* now );
+
+    private:
+        QObject* resolveActivationContext( QObject* trigger, QVector< QObject* >& chain );
+        QWidget* shortcutHostFor( QAction* act );
+
+    private:
+        typedef QPair< QWidget*, QString > ShortcutKey;
+
+        struct CachedActivationContext
+        {
+            QObject*                mContext;
+            QVector< QObject* >     mChain;     // Each one was the parent of the one before
+        };
+
+        struct ShortcutEntry
+        {
+            ShortcutEntry() : mShortcut( NULL ) {}
+
+            QShortcut*          mShortcut;
+            QList< QAction* >   mTargets;
+        };
+
+        QAction* shortcutTarget( const ShortcutEntry& entry );
+        void refreshShortcutEntry( const ShortcutEntry& entry );
+
     private:
         static UiManager* sSelf;
 
         QHash< QObject*, UiObjectPrivate* >                 mCreatedObjects;
+        QHash< QObject*, CachedActivationContext >          mActivationContexts;
         QHash< UiObjectPrivate*, QSet< UiObjectPrivate* > > mUioUsage;
+        int                                                 mActionBatchDepth;
+        QSet< ActionPrivate* >                              mPendingActions;
+        QSet< ActionPrivate* >                              mStaleActions;
+        QSet< ActionPrivate* >                              mEvaluatingActions;
+        bool                                                mStateEvaluationQueued;
+        QHash< ShortcutKey, ShortcutEntry >                 mShortcuts;
+        QHash< QAction*, ShortcutKey >                      mShortcutTargets;
+        QHash< QObject*, ShortcutKey >                      mShortcutKeys;
+        bool                                                mTrackingFocus;
+        bool                                                mShortcutRefreshQueued;
+        ActionIndex                                         mActionIndex;
     };
 
 }
@@ -18,6 +18,8 @@
 #include "libHeavenActions/UiObjectPrivate.hpp"
 #include "libHeavenActions/UiContainer.hpp"
 #include "libHeavenActions/UiManager.hpp"
+#include "libHeavenActions/ActionPrivate.hpp"
+#include "libHeavenActions/UiObjectArena.hpp"
 
 namespace Heaven
 {
@@ -50,9 +52,27 @@ namespace Heaven
         UiManager::self()->delUiObject( this );
     }
 
+    /**
+     * @internal
+     * @brief       Allocate a private object
+     *
+     * Private objects created inside a UiObjectArena::Scope live in that arena.
+     *
+     */
+    void* UiObjectPrivate::operator new( size_t size )
+    {
+        return UiObjectArena::allocate( size );
+    }
+
+    void UiObjectPrivate::operator delete( void* ptr )
+    {
+        UiObjectArena::release( ptr );
+    }
+
     void UiObjectPrivate::addedToContainer( UiContainer* container )
     {
         mContainers.insert( container );
+        UiManager::self()->actionIndex()->invalidate( this );
     }
 
     void UiObjectPrivate::removeFromContainer( UiContainer* container )
@@ -63,6 +83,7 @@ namespace Heaven
     void UiObjectPrivate::removedFromContainer( UiContainer* container )
     {
         mContainers.remove( container );
+        UiManager::self()->actionIndex()->invalidate( this );
     }
 
     void UiObjectPrivate::findActivationContext( QObject* trigger )
@@ -109,7 +130,16 @@ namespace Heaven
      */
     void UiObject::setActivationContext( QObject* context )
     {
-        mPrivate->mActivationContext = context;
+        if( mPrivate->mActivationContext != context )
+        {
+            mPrivate->mActivationContext = context;
+            UiManager::self()->invalidateActivationContexts();
+
+            if( mPrivate->type() == ActionType )
+            {
+                static_cast< ActionPrivate* >( mPrivate )->invalidateState();
+            }
+        }
     }
 
     /**
@@ -135,4 +165,39 @@ namespace Heaven
         return mPrivate->mActivatedBy;
     }
 
+    /**
+     * @brief       Defer the creation of a container's content
+     *
+     * @param[in]   provider            Function that adds the content to @a container, once it is
+     *                                  needed for the first time. Pass `NULL` to drop a provider
+     *                                  that was not called yet.
+     *
+     * @param[in]   context             Passed to @a provider as is.
+     *
+     * @param[in]   containsShortcuts   Set this to `true`, if any Action that @a provider will add
+     *                                  has a shortcut. Menus with shortcuts have to be populated
+     *                                  right away, else the shortcuts wouldn't work.
+     *
+     * The provider is called at most once: When the content is needed to populate a QMenu,
+     * QMenuBar or QToolBar or a QActionGroup for a widget. Code generated by hic with the `--lazy`
+     * option uses this to skip creating the content of containers that are never shown.
+     *
+     * This only has an effect on containers (Menu, MenuBar, ToolBar, ActionContainer and
+     * ActionGroup).
+     *
+     */
+    void UiObject::setContentProvider( ContentProvider provider, void* context,
+                                       bool containsShortcuts )
+    {
+        UiContainer* container = qobject_cast< UiContainer* >( mPrivate );
+        if( !container )
+        {
+            qWarning( "UiObject::setContentProvider: %s is not a container",
+                      qPrintable( objectName() ) );
+            return;
+        }
+
+        container->setContentProvider( provider, context, containsShortcuts );
+    }
+
 }
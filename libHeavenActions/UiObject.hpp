@@ -34,11 +34,17 @@ namespace Heaven
         UiObject( QObject* parent, UiObjectPrivate* privateClass );
         ~UiObject();
 
+    public:
+        typedef void (*ContentProvider)( void* context, UiObject* container );
+
     public:
         void setActivationContext( QObject* context );
         QObject* activationContext() const;
         QObject* activatedBy() const;
 
+        void setContentProvider( ContentProvider provider, void* context,
+                                 bool containsShortcuts = false );
+
     protected:
         friend class UiContainer;
         UiObjectPrivate* mPrivate;  //!< private data object of this ui object
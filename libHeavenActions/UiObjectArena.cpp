@@ -0,0 +1,225 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <new>
+
+#include <QList>
+
+#include "libHeavenActions/UiObjectArena.hpp"
+
+namespace Heaven
+{
+
+    /**
+     * @class       UiObjectArena
+     * @ingroup     Actions
+     * @brief       Allocates the private objects of a block of ui objects in one go
+     *
+     * A hic generated setupActions() creates all actions, menus and containers of a Ui block at
+     * once. Each of them comes with a private object. While a UiObjectArena::Scope is active, all
+     * private objects are carved out of a few large blocks of the arena instead of being allocated
+     * one by one.
+     *
+     * The objects themselves still die one by one, whenever their public counterpart is deleted.
+     * The blocks of an arena are freed together when both the arena is destroyed and the last
+     * object that lives in it has been deleted - whichever comes last. Hic generated Ui classes
+     * own an arena, so their objects are freed when the Ui is gone.
+     *
+     * Only the GUI thread may create ui objects, so there is no locking involved.
+     *
+     */
+
+    class UiObjectArenaData
+    {
+    public:
+        UiObjectArenaData();
+        ~UiObjectArenaData();
+
+    public:
+        void* allocate( size_t size );
+        void release();
+        void detach();
+
+    public:
+        QList< char* >  mBlocks;
+        size_t          mUsed;
+        int             mLiveObjects;
+        bool            mDetached;
+    };
+
+    /**
+     * @internal
+     * @brief       Header in front of each allocation, so operator delete knows where it is from
+     *
+     * The union keeps the object behind the header aligned for any type.
+     */
+    union UiObjectArenaHeader
+    {
+        UiObjectArenaData*  mArena;
+        double              mAlignDouble;
+        long long           mAlignLong;
+        void*               mAlignPointer;
+    };
+
+    static const size_t sArenaBlockSize = 16 * 1024;
+    static UiObjectArenaData* sCurrentArena = NULL;
+
+    static size_t alignedSize( size_t size )
+    {
+        const size_t align = sizeof( UiObjectArenaHeader );
+        return ( size + align - 1 ) / align * align;
+    }
+
+    UiObjectArenaData::UiObjectArenaData()
+        : mUsed( sArenaBlockSize )
+        , mLiveObjects( 0 )
+        , mDetached( false )
+    {
+    }
+
+    UiObjectArenaData::~UiObjectArenaData()
+    {
+        foreach( char* block, mBlocks )
+        {
+            ::operator delete( block );
+        }
+    }
+
+    void* UiObjectArenaData::allocate( size_t size )
+    {
+        size = alignedSize( size );
+
+        if( size > sArenaBlockSize )
+        {
+            // Nothing of ours is that large; give it a block of its own, but keep the current one.
+            char* block = static_cast< char* >( ::operator new( size ) );
+            mBlocks.prepend( block );
+            mLiveObjects++;
+            return block;
+        }
+
+        if( mUsed + size > sArenaBlockSize )
+        {
+            mBlocks.append( static_cast< char* >( ::operator new( sArenaBlockSize ) ) );
+            mUsed = 0;
+        }
+
+        void* ptr = mBlocks.last() + mUsed;
+        mUsed += size;
+        mLiveObjects++;
+
+        return ptr;
+    }
+
+    void UiObjectArenaData::release()
+    {
+        if( --mLiveObjects == 0 && mDetached )
+        {
+            delete this;
+        }
+    }
+
+    void UiObjectArenaData::detach()
+    {
+        mDetached = true;
+
+        if( sCurrentArena == this )
+        {
+            sCurrentArena = NULL;
+        }
+
+        if( mLiveObjects == 0 )
+        {
+            delete this;
+        }
+    }
+
+    UiObjectArena::UiObjectArena()
+        : d( new UiObjectArenaData )
+    {
+    }
+
+    UiObjectArena::~UiObjectArena()
+    {
+        d->detach();
+    }
+
+    /**
+     * @brief       Allocate memory for a ui object's private object
+     *
+     * @param[in]   size    Number of bytes to allocate.
+     *
+     * @return      The memory. It is taken from the arena of the innermost active Scope, or from
+     *              the heap if there is none.
+     *
+     */
+    void* UiObjectArena::allocate( size_t size )
+    {
+        const size_t total = sizeof( UiObjectArenaHeader ) + size;
+        UiObjectArenaHeader* header;
+
+        if( sCurrentArena )
+        {
+            header = static_cast< UiObjectArenaHeader* >( sCurrentArena->allocate( total ) );
+        }
+        else
+        {
+            header = static_cast< UiObjectArenaHeader* >( ::operator new( total ) );
+        }
+
+        header->mArena = sCurrentArena;
+        return header + 1;
+    }
+
+    void UiObjectArena::release( void* ptr )
+    {
+        if( !ptr )
+        {
+            return;
+        }
+
+        UiObjectArenaHeader* header = static_cast< UiObjectArenaHeader* >( ptr ) - 1;
+
+        if( header->mArena )
+        {
+            header->mArena->release();
+        }
+        else
+        {
+            ::operator delete( header );
+        }
+    }
+
+    /**
+     * @class       UiObjectArena::Scope
+     * @brief       Routes all private object allocations into an arena while it exists
+     *
+     * Scopes may be nested; the previous arena is restored when a Scope is destroyed.
+     *
+     */
+
+    UiObjectArena::Scope::Scope( UiObjectArena& arena )
+        : mPrevious( sCurrentArena )
+    {
+        sCurrentArena = arena.d;
+    }
+
+    UiObjectArena::Scope::~Scope()
+    {
+        sCurrentArena = mPrevious;
+    }
+
+}
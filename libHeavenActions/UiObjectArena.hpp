@@ -0,0 +1,58 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MGV_HEAVEN_UIOBJECT_ARENA_H
+#define MGV_HEAVEN_UIOBJECT_ARENA_H
+
+#include <cstddef>
+
+#include "libHeavenActions/libHeavenActionsAPI.hpp"
+
+namespace Heaven
+{
+
+    class UiObjectArenaData;
+
+    class HEAVEN_ACTIONS_API UiObjectArena
+    {
+    public:
+        UiObjectArena();
+        ~UiObjectArena();
+
+    public:
+        class HEAVEN_ACTIONS_API Scope
+        {
+        public:
+            Scope( UiObjectArena& arena );
+            ~Scope();
+
+        private:
+            Q_DISABLE_COPY( Scope )
+            UiObjectArenaData* mPrevious;
+        };
+
+    public:
+        static void* allocate( size_t size );
+        static void release( void* ptr );
+
+    private:
+        Q_DISABLE_COPY( UiObjectArena )
+        UiObjectArenaData* d;
+    };
+
+}
+
+#endif
@@ -38,6 +38,10 @@ namespace Heaven
     public:
         ~UiObjectPrivate();
 
+    public:
+        static void* operator new( size_t size );
+        static void operator delete( void* ptr );
+
     public:
         virtual UiObjectTypes type() const = 0;
 
@@ -15,15 +15,14 @@
  */
 
 #include <QDebug>
-#include <QQueue>
-#include <QStringBuilder>
-#include <QTreeWidgetItem>
 #include <QHeaderView>
 #include <QPainter>
 
 #include "libHeavenColors/ColorSchemaEditor.hpp"
 #include "libHeavenColors/ColorManager.hpp"
+#include "libHeavenColors/ColorManagerPrivate.hpp"
 #include "libHeavenColors/ColorSchema.hpp"
+#include "libHeavenColors/ColorSetModel.hpp"
 
 #include "ui_ColorSchemaEditor.h"
 
@@ -43,9 +42,7 @@ namespace Heaven
 
         if( index.column() > 0 )
         {
-            QModelIndex nameIdx = index.model()->index( index.row(), 0, index.parent() );
-            QByteArray colorName = nameIdx.data( Qt::UserRole ).toByteArray();
-            ColorId id = ColorManager::self().colorId( colorName );
+            ColorId id = ColorListModel::colorId( index );
 
             QRect r( 2 + option.rect.left() + option.rect.width() / 2 - 20,
                      2 + option.rect.top(),
@@ -55,9 +52,17 @@ namespace Heaven
 
             switch( index.column() )
             {
-            case 1: clr = ColorManager::self().get( id, QPalette::Active ); break;
-            case 2: clr = ColorManager::self().get( id, QPalette::Inactive ); break;
-            case 3: clr = ColorManager::self().get( id, QPalette::Disabled ); break;
+            case ColorListModel::ActiveColumn:
+                clr = ColorManager::get( id, QPalette::Active );
+                break;
+
+            case ColorListModel::InactiveColumn:
+                clr = ColorManager::get( id, QPalette::Inactive );
+                break;
+
+            case ColorListModel::DisabledColumn:
+                clr = ColorManager::get( id, QPalette::Disabled );
+                break;
             }
 
             painter->fillRect( r, clr );
@@ -73,14 +78,22 @@ namespace Heaven
         ui = new Ui::ColorSchemaEditor;
         ui->setupUi( this );
 
+        mTreeModel = new ColorSetModel( &ColorManager::self().d->mRootSet, this );
+        mListModel = new ColorListModel( this );
+
+        ui->tvColorTree->setModel( mTreeModel );
+        ui->tvColorList->setModel( mListModel );
+
+        QHeaderView* head = ui->tvColorList->header();
         #if QT_VERSION < 0x050000
-        QHeaderView* head = ui->twColorList->header();
-        head->setResizeMode( 0, QHeaderView::ResizeToContents );
+        head->setResizeMode( ColorListModel::NameColumn, QHeaderView::ResizeToContents );
+        #else
+        head->setSectionResizeMode( ColorListModel::NameColumn, QHeaderView::ResizeToContents );
         #endif
 
-        ui->twColorList->setItemDelegate( new ColorSchemaDelegate );
+        ui->tvColorList->setItemDelegate( new ColorSchemaDelegate( this ) );
 
-        connect( ui->twColorTree->selectionModel(),
+        connect( ui->tvColorTree->selectionModel(),
                  SIGNAL(selectionChanged(QItemSelection,QItemSelection)),
                  this,
                  SLOT(onTreeChanged()) );
@@ -117,56 +130,27 @@ namespace Heaven
 
     void ColorSchemaEditor::setupColorTree()
     {
-        typedef QPair< QByteArray, QTreeWidgetItem* > QueueItem;
-        QQueue< QueueItem > todo;
+        // Only the top level groups are expanded; deeper levels are fetched by the model once
+        // the user opens them.
+        mTreeModel->fetchMore( QModelIndex() );
 
-        foreach( QByteArray g, ColorManager::self().sortedChildren( QByteArray() ) )
+        for( int i = 0; i < mTreeModel->rowCount(); i++ )
         {
-            todo.enqueue( QueueItem( g, ui->twColorTree->invisibleRootItem() ) );
-        }
-
-        while( !todo.isEmpty() )
-        {
-            QueueItem it = todo.dequeue();
-
-            QTreeWidgetItem* item = new QTreeWidgetItem( it.second );
-            item->setText( 0, ColorManager::self().translatedPathName( it.first ) );
-            item->setData( 0, Qt::UserRole, it.first );
-            item->setExpanded( true );
-
-            QList< QByteArray > groups = ColorManager::self().sortedChildren( it.first );
-            foreach( QByteArray group, groups )
-            {
-                todo.enqueue( QueueItem( it.first % '/' % group, item ) );
-            }
+            ui->tvColorTree->expand( mTreeModel->index( i, 0 ) );
         }
     }
 
     void ColorSchemaEditor::onTreeChanged()
     {
-        QModelIndexList mil = ui->twColorTree->selectionModel()->selectedRows();
-
-        if( mil.count() == 0 )
-            return;
+        QModelIndexList mil = ui->tvColorTree->selectionModel()->selectedRows();
 
         if( mil.count() != 1 )
-            return;
-
-        QByteArray path = mil[0].data( Qt::UserRole ).toByteArray();
-        setupColorList( path );
-    }
-
-    void ColorSchemaEditor::setupColorList( const QByteArray& path )
-    {
-        ui->twColorList->clear();
-
-        foreach( QByteArray subPath, ColorManager::self().sortedColors( path ) )
         {
-            QString name = ColorManager::self().translatedColorName( path, subPath );
-            QTreeWidgetItem* it = new QTreeWidgetItem( ui->twColorList );
-            it->setData( 0, Qt::DisplayRole, name );
-            it->setData( 0, Qt::UserRole, QVariant( path % '/' % subPath ) );
+            mListModel->setColorSet( NULL );
+            return;
         }
+
+        mListModel->setColorSet( mTreeModel->colorSet( mil[ 0 ] ) );
     }
 
 }
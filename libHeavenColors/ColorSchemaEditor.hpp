@@ -28,6 +28,9 @@ namespace Ui
 namespace Heaven
 {
 
+    class ColorSetModel;
+    class ColorListModel;
+
     class ColorSchemaEditor : public QWidget
     {
         Q_OBJECT
@@ -38,13 +41,14 @@ namespace Heaven
     private:
         void setupSchemata();
         void setupColorTree();
-        void setupColorList( const QByteArray& path );
 
     private slots:
         void onTreeChanged();
 
     private:
         Ui::ColorSchemaEditor* ui;
+        ColorSetModel* mTreeModel;
+        ColorListModel* mListModel;
     };
 
     class ColorSchemaDelegate : public QItemDelegate
@@ -0,0 +1,335 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QtAlgorithms>
+
+#include "libHeavenColors/ColorSetModel.hpp"
+
+namespace Heaven
+{
+
+    /**
+     * @internal
+     * @brief       Number of color rows a ColorListModel exposes per fetchMore() call
+     */
+    static const int sColorFetchBatch = 64;
+
+    static bool colorSetLessThan( const ColorSet* a, const ColorSet* b )
+    {
+        return a->sortOrder() < b->sortOrder();
+    }
+
+    static bool colorDefLessThan( const ColorDef& a, const ColorDef& b )
+    {
+        return a.sortOrder() < b.sortOrder();
+    }
+
+    ColorSetModel::Node::Node( ColorSet* set, Node* parent, int row )
+        : mSet( set )
+        , mParent( parent )
+        , mRow( row )
+        , mFetched( false )
+    {
+    }
+
+    ColorSetModel::Node::~Node()
+    {
+        qDeleteAll( mChildren );
+    }
+
+    ColorSetModel::ColorSetModel( ColorSet* root, QObject* parent )
+        : QAbstractItemModel( parent )
+        , mRoot( new Node( root, NULL, 0 ) )
+    {
+    }
+
+    ColorSetModel::~ColorSetModel()
+    {
+        delete mRoot;
+    }
+
+    ColorSetModel::Node* ColorSetModel::nodeFor( const QModelIndex& index ) const
+    {
+        if( !index.isValid() )
+        {
+            return mRoot;
+        }
+
+        return static_cast< Node* >( index.internalPointer() );
+    }
+
+    ColorSet* ColorSetModel::colorSet( const QModelIndex& index ) const
+    {
+        if( !index.isValid() )
+        {
+            return NULL;
+        }
+
+        return nodeFor( index )->mSet;
+    }
+
+    QModelIndex ColorSetModel::index( int row, int column, const QModelIndex& parent ) const
+    {
+        Node* parentNode = nodeFor( parent );
+
+        if( column != 0 || row < 0 || row >= parentNode->mChildren.count() )
+        {
+            return QModelIndex();
+        }
+
+        return createIndex( row, column, parentNode->mChildren.at( row ) );
+    }
+
+    QModelIndex ColorSetModel::parent( const QModelIndex& child ) const
+    {
+        if( !child.isValid() )
+        {
+            return QModelIndex();
+        }
+
+        Node* parentNode = nodeFor( child )->mParent;
+        if( !parentNode || parentNode == mRoot )
+        {
+            return QModelIndex();
+        }
+
+        return createIndex( parentNode->mRow, 0, parentNode );
+    }
+
+    int ColorSetModel::rowCount( const QModelIndex& parent ) const
+    {
+        if( parent.column() > 0 )
+        {
+            return 0;
+        }
+
+        return nodeFor( parent )->mChildren.count();
+    }
+
+    int ColorSetModel::columnCount( const QModelIndex& parent ) const
+    {
+        Q_UNUSED( parent );
+        return 1;
+    }
+
+    bool ColorSetModel::hasChildren( const QModelIndex& parent ) const
+    {
+        Node* node = nodeFor( parent );
+
+        if( node->mFetched )
+        {
+            return !node->mChildren.isEmpty();
+        }
+
+        // Ask the ColorSet itself; the children are only wrapped in nodes on fetchMore().
+        return !node->mSet->children().isEmpty();
+    }
+
+    bool ColorSetModel::canFetchMore( const QModelIndex& parent ) const
+    {
+        return !nodeFor( parent )->mFetched;
+    }
+
+    void ColorSetModel::fetchMore( const QModelIndex& parent )
+    {
+        Node* node = nodeFor( parent );
+        if( node->mFetched )
+        {
+            return;
+        }
+
+        node->mFetched = true;
+
+        QList< ColorSet* > sets = node->mSet->children();
+        if( sets.isEmpty() )
+        {
+            return;
+        }
+
+        qStableSort( sets.begin(), sets.end(), colorSetLessThan );
+
+        beginInsertRows( parent, 0, sets.count() - 1 );
+
+        for( int i = 0; i < sets.count(); i++ )
+        {
+            node->mChildren.append( new Node( sets.at( i ), node, i ) );
+        }
+
+        endInsertRows();
+    }
+
+    QVariant ColorSetModel::data( const QModelIndex& index, int role ) const
+    {
+        ColorSet* set = colorSet( index );
+        if( !set )
+        {
+            return QVariant();
+        }
+
+        switch( role )
+        {
+        case Qt::DisplayRole:
+            return set->translatedName();
+
+        case ColorSetPathRole:
+            return set->path();
+
+        default:
+            return QVariant();
+        }
+    }
+
+    ColorListModel::ColorListModel( QObject* parent )
+        : QAbstractItemModel( parent )
+        , mSet( NULL )
+        , mFetched( 0 )
+    {
+    }
+
+    ColorSet* ColorListModel::colorSet() const
+    {
+        return mSet;
+    }
+
+    void ColorListModel::setColorSet( ColorSet* set )
+    {
+        if( set == mSet )
+        {
+            return;
+        }
+
+        beginResetModel();
+
+        mSet = set;
+        mColors.clear();
+        mFetched = 0;
+
+        if( mSet )
+        {
+            // colorDefs() hands out a copy of a hash; sort it once here instead of resolving
+            // each color by its path when a row is painted.
+            QHash< QByteArray, ColorDef > defs = mSet->colorDefs();
+            mColors.reserve( defs.count() );
+
+            foreach( ColorDef def, defs )
+            {
+                mColors.append( def );
+            }
+
+            qStableSort( mColors.begin(), mColors.end(), colorDefLessThan );
+        }
+
+        endResetModel();
+    }
+
+    ColorId ColorListModel::colorId( const QModelIndex& index )
+    {
+        return ColorId( index.internalId() );
+    }
+
+    QModelIndex ColorListModel::index( int row, int column, const QModelIndex& parent ) const
+    {
+        if( parent.isValid() || row < 0 || row >= mFetched ||
+            column < 0 || column >= ColumnCount )
+        {
+            return QModelIndex();
+        }
+
+        return createIndex( row, column, quint32( quint16( mColors.at( row ).id() ) ) );
+    }
+
+    QModelIndex ColorListModel::parent( const QModelIndex& child ) const
+    {
+        Q_UNUSED( child );
+        return QModelIndex();
+    }
+
+    int ColorListModel::rowCount( const QModelIndex& parent ) const
+    {
+        return parent.isValid() ? 0 : mFetched;
+    }
+
+    int ColorListModel::columnCount( const QModelIndex& parent ) const
+    {
+        return parent.isValid() ? 0 : int( ColumnCount );
+    }
+
+    bool ColorListModel::canFetchMore( const QModelIndex& parent ) const
+    {
+        return !parent.isValid() && mFetched < mColors.count();
+    }
+
+    void ColorListModel::fetchMore( const QModelIndex& parent )
+    {
+        if( parent.isValid() )
+        {
+            return;
+        }
+
+        int count = qMin( sColorFetchBatch, mColors.count() - mFetched );
+        if( count <= 0 )
+        {
+            return;
+        }
+
+        beginInsertRows( QModelIndex(), mFetched, mFetched + count - 1 );
+        mFetched += count;
+        endInsertRows();
+    }
+
+    QVariant ColorListModel::data( const QModelIndex& index, int role ) const
+    {
+        if( !index.isValid() || index.row() >= mFetched )
+        {
+            return QVariant();
+        }
+
+        switch( role )
+        {
+        case Qt::DisplayRole:
+            if( index.column() == NameColumn )
+            {
+                return mColors.at( index.row() ).translatedName();
+            }
+            return QVariant();
+
+        case ColorIdRole:
+            return int( mColors.at( index.row() ).id() );
+
+        default:
+            return QVariant();
+        }
+    }
+
+    QVariant ColorListModel::headerData( int section, Qt::Orientation orientation,
+                                         int role ) const
+    {
+        if( orientation != Qt::Horizontal || role != Qt::DisplayRole )
+        {
+            return QVariant();
+        }
+
+        switch( section )
+        {
+        case NameColumn:        return trUtf8( "Color" );
+        case ActiveColumn:      return trUtf8( "Active" );
+        case InactiveColumn:    return trUtf8( "Inactive" );
+        case DisabledColumn:    return trUtf8( "Disabled" );
+        default:                return QVariant();
+        }
+    }
+
+}
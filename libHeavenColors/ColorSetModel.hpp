@@ -0,0 +1,123 @@
+/*
+ * libHeaven - A Qt-based ui framework for strongly modularized applications
+ * Copyright (C) 2012-2013 Sascha Cunz <sascha@babbelbox.org>
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License (Version 2) as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef HEAVEN_COLOR_SCHEMATA_COLOR_SET_MODEL_HPP
+#define HEAVEN_COLOR_SCHEMATA_COLOR_SET_MODEL_HPP
+
+#include <QAbstractItemModel>
+#include <QVector>
+#include <QList>
+
+#include "libHeavenColors/ColorSet.hpp"
+
+namespace Heaven
+{
+
+    class ColorSetModel : public QAbstractItemModel
+    {
+        Q_OBJECT
+    public:
+        enum Roles
+        {
+            ColorSetPathRole = Qt::UserRole
+        };
+
+    public:
+        ColorSetModel( ColorSet* root, QObject* parent = 0 );
+        ~ColorSetModel();
+
+    public:
+        QModelIndex index( int row, int column, const QModelIndex& parent = QModelIndex() ) const;
+        QModelIndex parent( const QModelIndex& child ) const;
+        int rowCount( const QModelIndex& parent = QModelIndex() ) const;
+        int columnCount( const QModelIndex& parent = QModelIndex() ) const;
+        bool hasChildren( const QModelIndex& parent = QModelIndex() ) const;
+        QVariant data( const QModelIndex& index, int role = Qt::DisplayRole ) const;
+
+        bool canFetchMore( const QModelIndex& parent ) const;
+        void fetchMore( const QModelIndex& parent );
+
+    public:
+        ColorSet* colorSet( const QModelIndex& index ) const;
+
+    private:
+        struct Node
+        {
+            Node( ColorSet* set, Node* parent, int row );
+            ~Node();
+
+            ColorSet*       mSet;
+            Node*           mParent;
+            int             mRow;
+            bool            mFetched;
+            QList< Node* >  mChildren;
+        };
+
+        Node* nodeFor( const QModelIndex& index ) const;
+
+    private:
+        Node*   mRoot;
+    };
+
+    class ColorListModel : public QAbstractItemModel
+    {
+        Q_OBJECT
+    public:
+        enum Roles
+        {
+            ColorIdRole = Qt::UserRole
+        };
+
+        enum Columns
+        {
+            NameColumn,
+            ActiveColumn,
+            InactiveColumn,
+            DisabledColumn,
+
+            ColumnCount
+        };
+
+    public:
+        ColorListModel( QObject* parent = 0 );
+
+    public:
+        void setColorSet( ColorSet* set );
+        ColorSet* colorSet() const;
+
+        static ColorId colorId( const QModelIndex& index );
+
+    public:
+        QModelIndex index( int row, int column, const QModelIndex& parent = QModelIndex() ) const;
+        QModelIndex parent( const QModelIndex& child ) const;
+        int rowCount( const QModelIndex& parent = QModelIndex() ) const;
+        int columnCount( const QModelIndex& parent = QModelIndex() ) const;
+        QVariant data( const QModelIndex& index, int role = Qt::DisplayRole ) const;
+        QVariant headerData( int section, Qt::Orientation orientation,
+                             int role = Qt::DisplayRole ) const;
+
+        bool canFetchMore( const QModelIndex& parent ) const;
+        void fetchMore( const QModelIndex& parent );
+
+    private:
+        ColorSet*           mSet;
+        QVector< ColorDef > mColors;
+        int                 mFetched;
+    };
+
+}
+
+#endif